@@ -9,8 +9,13 @@ message("You are running qmake on a generated .pro file. This may not work!")
 
 HEADERS += ./ExtendMeshHeaders.h \
     ./TextureSynthesis/Block.h \
+    ./TextureSynthesis/BlockMatcher.h \
+    ./TextureSynthesis/CoherenceSynthesizer.h \
     ./TextureSynthesis/CutMask.h \
     ./TextureSynthesis/Globals.h \
+    ./TextureSynthesis/PatchSynthesizer.h \
+    ./TextureSynthesis/PyramidSynthesizer.h \
+    ./TextureSynthesis/SynthesisRunner.h \
     ./TextureSynthesis/Synthesizer.h \
     ./TextureSynthesis/SynthesizerDialog.h \
     ./TextureSynthesis/TextureSynthesizer.h \
@@ -27,6 +32,7 @@ HEADERS += ./ExtendMeshHeaders.h \
     ./GraphicsLibrary/Line.h \
     ./GraphicsLibrary/LocalFrame.h \
     ./GraphicsLibrary/Mesh.h \
+    ./GraphicsLibrary/MeshWriter.h \
     ./GraphicsLibrary/Octree.h \
     ./GraphicsLibrary/Plane.h \
     ./GraphicsLibrary/Point.h \
@@ -68,6 +74,7 @@ HEADERS += ./ExtendMeshHeaders.h \
     ./GeometrySynthesis/Grid.h \
     ./GeometrySynthesis/GridMesh.h \
     ./GeometrySynthesis/GridMeshStretch.h \
+    ./GeometrySynthesis/GridMeshStream.h \
     ./GeometrySynthesis/GridPoint.h \
     ./GeometrySynthesis/GridSquare.h \
     ./GeometrySynthesis/GridVisualizer.h \
@@ -76,6 +83,7 @@ HEADERS += ./ExtendMeshHeaders.h \
     ./GeometrySynthesis/Sampling.h \
     ./GeometrySynthesis/Seam.h \
     ./GeometrySynthesis/SimpleSquare.h \
+    ./GeometrySynthesis/SquareFrame.h \
     ./GeometrySynthesis/SmoothStairway.h \
     ./GeometrySynthesis/SmoothStep.h \
     ./GeometrySynthesis/Stitcher.h \
@@ -85,7 +93,12 @@ HEADERS += ./ExtendMeshHeaders.h \
     ./BezierSpline/Spline.h
 SOURCES += ./main.cpp \
     ./TextureSynthesis/Block.cpp \
+    ./TextureSynthesis/BlockMatcher.cpp \
+    ./TextureSynthesis/CoherenceSynthesizer.cpp \
     ./TextureSynthesis/CutMask.cpp \
+    ./TextureSynthesis/PatchSynthesizer.cpp \
+    ./TextureSynthesis/PyramidSynthesizer.cpp \
+    ./TextureSynthesis/SynthesisRunner.cpp \
     ./TextureSynthesis/Synthesizer.cpp \
     ./TextureSynthesis/SynthesizerDialog.cpp \
     ./TextureSynthesis/TextureSynthesizer.cpp \
@@ -98,6 +111,7 @@ SOURCES += ./main.cpp \
     ./GraphicsLibrary/Line.cpp \
     ./GraphicsLibrary/LocalFrame.cpp \
     ./GraphicsLibrary/Mesh.cpp \
+    ./GraphicsLibrary/MeshWriter.cpp \
     ./GraphicsLibrary/Octree.cpp \
     ./GraphicsLibrary/Plane.cpp \
     ./GraphicsLibrary/Slicer.cpp \
@@ -126,6 +140,7 @@ SOURCES += ./main.cpp \
     ./GeometrySynthesis/Grid.cpp \
     ./GeometrySynthesis/GridMesh.cpp \
     ./GeometrySynthesis/GridMeshStretch.cpp \
+    ./GeometrySynthesis/GridMeshStream.cpp \
     ./GeometrySynthesis/GridSquare.cpp \
     ./GeometrySynthesis/GridVisualizer.cpp \
     ./GeometrySynthesis/MeshPatch.cpp \
@@ -4,7 +4,8 @@
 #include "SimpleDraw.h"
 
 Displacements::Displacements(Mesh * source, Skeleton * srcSkeleton, int numberSteps, 
-							 int numIteration, float smoothStepSize, bool isVolumePreserve)
+							 int numIteration, float smoothStepSize, bool isVolumePreserve,
+							 const Vector<int> & smoothRegion)
 {
 	this->sourceMesh = source;
 	this->skeleton = srcSkeleton;
@@ -13,8 +14,8 @@ Displacements::Displacements(Mesh * source, Skeleton * srcSkeleton, int numberSt
 
 	stats["smoothing"] = Stats("Base extraction (smoothing)");
 
-	// Create smooth stairway structure
-	stair = SmoothStairway(source, numberSteps, numIteration, smoothStepSize, isVolumePreserve);
+	// Create smooth stairway structure, possibly only around a region
+	stair = SmoothStairway(source, numberSteps, numIteration, smoothStepSize, isVolumePreserve, smoothRegion);
 
 	stats["smoothing"].end();
 
@@ -62,12 +63,25 @@ void Displacements::computeField(int gridSquareSize, int fitMethod, int lRotate,
 	if(radius <= 0.0f)	
 		radius = stair.mostDetailedMesh()->radius * 0.1; // just in case...
 
+	// Before the grid relaxes the spine
+	unsigned int key = fieldKey(selectedFaces, skeletonPoints, gridSquareSize, fitMethod, lRotate, rRotate);
+	QString cacheFile = QString("grid_%1.cache").arg(key, 8, 16, QChar('0'));
+
 	CreateTimer(gridTimer);
 
 	// CREATE GRID
 	grid = Grid(skeletonPoints, radius, gridLength, gridSquareSize, &stair, meshFaces,lRotate, rRotate);
 
 	printf(".Grid time (%d ms).", (int)gridTimer.elapsed());
+
+	// Same inputs as a previous session, skip fitting and gridifying
+	if(grid.loadCache(cacheFile, key))
+	{
+		isReady = true;
+
+		printf("\n\nField loaded from %s = %d ms\n=======\n", cacheFile.toStdString().c_str(), (int)allTimer.elapsed());
+		return;
+	}
 	CreateTimer(fitTimer);
 
 	// FIT GRID
@@ -91,11 +105,54 @@ void Displacements::computeField(int gridSquareSize, int fitMethod, int lRotate,
 
 	isReady = true;
 
+	if(!grid.saveCache(cacheFile, key))
+		printf("\nCould not write %s\n", cacheFile.toStdString().c_str());
+
 	printf(".total Gridify time = %d ms\n", (int)gridifyTimer.elapsed());
 
 	printf("\n\nField time = %d ms\n=======\n", (int)allTimer.elapsed());
 }
 
+unsigned int Displacements::fieldKey(const Vector<int> & selectedFaces, const Vector<Vec> & spine, 
+									int gridSquareSize, int fitMethod, int lRotate, int rRotate)
+{
+	Vector<unsigned int> words;
+
+	words.push_back(SmoothStairway::meshVersion(stair.mostDetailedMesh()));
+	words.push_back(SmoothStairway::meshVersion(stair.mostBaseMesh()));
+	words.push_back(stair.numberOfSteps());
+
+	words.push_back(gridSquareSize);
+	words.push_back(fitMethod);
+	words.push_back(lRotate);
+	words.push_back(rRotate);
+
+	words.push_back(selectedFaces.size());
+	words.insert(words.end(), selectedFaces.begin(), selectedFaces.end());
+
+	words.push_back(spine.size());
+
+	for(int i = 0; i < (int)spine.size(); i++)
+	{
+		float coord[3] = { (float)spine[i].x, (float)spine[i].y, (float)spine[i].z };
+		unsigned int bits;
+
+		for(int c = 0; c < 3; c++)
+		{
+			memcpy(&bits, &coord[c], sizeof(bits));
+			words.push_back(bits);
+		}
+	}
+
+	// FNV-1a, as for mesh versions
+	unsigned int hash = 2166136261u;
+
+	for(int i = 0; i < (int)words.size(); i++)
+		hash = (hash ^ words[i]) * 16777619u;
+
+	return hash;
+}
+
 Grid * Displacements::GetGrid()
 {
 	return &grid;
@@ -22,13 +22,18 @@ private:
 	bool isDrawStair;
 	bool isUserFriendly;
 
+	// Identifies the inputs of a field, names its cached grid
+	unsigned int fieldKey(const Vector<int> & selectedFaces, const Vector<Vec> & spine, 
+		int gridSquareSize, int fitMethod, int lRotate, int rRotate);
+
 public:
 
 	bool isReady;
 
 	// CONSTRUCTORS
 	Displacements(Mesh * source, Skeleton * srcSkeleton,
-		int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve);
+		int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve,
+		const Vector<int> & smoothRegion = Vector<int>());
 
 	// ACCESSORS
 	Grid * GetGrid();
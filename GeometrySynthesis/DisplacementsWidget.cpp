@@ -10,6 +10,27 @@ using namespace Matrixf;
 // Special case: regular stretch
 #include "GridMeshStretch.h"
 
+// Chunked output of large extensions
+#include "GridMeshStream.h"
+
+// Same synthesis input, the curve may differ
+static bool sameSynthesis(const SynthSettings & a, const SynthSettings & b)
+{
+	return a.type == b.type && a.extension == b.extension && a.blockSize == b.blockSize 
+		&& a.bandSize == b.bandSize && a.options == b.options 
+		&& a.crop.l == b.crop.l && a.crop.r == b.crop.r && a.crop.t == b.crop.t && a.crop.b == b.crop.b;
+}
+
+static bool sameCurve(const Vector<Vec> & a, const Vector<Vec> & b)
+{
+	if(a.size() != b.size()) return false;
+
+	for(int i = 0; i < (int)a.size(); i++)
+		if(a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) return false;
+
+	return true;
+}
+
 DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *parent) : QWidget(parent)
 {
 	this->sourceMesh = mesh;
@@ -34,6 +55,7 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 	grid_square_size = new QSpinBox();
 	fitting_method = new QComboBox();
 	volume_preserve = new QCheckBox("preserve volume");
+	smooth_selection = new QCheckBox("selection only");
 
 	int row = 0;
 	optionsLayout->addWidget(new QLabel("Smoothing Options:"), row++, 0, 1, 3);
@@ -43,7 +65,8 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 	optionsLayout->addWidget(num_iteration, row++, 2);
 	optionsLayout->addWidget(new QLabel("Step Size"), row, 0);
 	optionsLayout->addWidget(step_size, row++, 2);
-	optionsLayout->addWidget(volume_preserve, row++, 0);
+	optionsLayout->addWidget(volume_preserve, row, 0);
+	optionsLayout->addWidget(smooth_selection, row++, 2);
 
 	buttonSmoothing = new QPushButton("Compute Base");
 	optionsLayout->addWidget(buttonSmoothing, row++, 0, 1, 3);
@@ -150,6 +173,8 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 
 	synthesisType->addItem("Tiling");
 	synthesisType->addItem("Patch-Based");
+	synthesisType->addItem("Multi-resolution");
+	synthesisType->addItem("Coherence (PatchMatch)");
 	synthesisType->addItem("Nearest-neighbor interpolation");
 	synthesisType->addItem("Stretch");
 
@@ -189,6 +214,9 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 	buttonTriangulate = new QPushButton("Merge and Output..");
 	layout->addWidget(buttonTriangulate);
 
+	buttonStreamOutput = new QPushButton("Stream Extension to OBJ..");
+	layout->addWidget(buttonStreamOutput);
+
 	// RESULTS =====================================================
 	resultsWidget = new QDockWidget("Results", this);
 	resultsFrame = new QFrame(this);
@@ -220,6 +248,7 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 	QObject::connect(smooth_level, SIGNAL(sliderMoved(int)), gv, SLOT(SetLevel(int)));
 	QObject::connect(buttonTogglePatch,  SIGNAL(clicked()), gv, SLOT(ToggleShowPatch()));
 	QObject::connect(buttonTriangulate, SIGNAL(clicked()), this, SLOT(Triangulate()));
+	QObject::connect(buttonStreamOutput, SIGNAL(clicked()), this, SLOT(StreamExtension()));
 	QObject::connect(this, SIGNAL(GridChanged(Grid*)), gv, SLOT(SetGrid(Grid*)));
 
 	this->setLayout(layout);
@@ -227,6 +256,7 @@ DisplacementsWidget::DisplacementsWidget(Mesh *mesh, Skeleton *s, QWidget *paren
 	df = NULL;
 
 	firstGridMesh = false;
+	prevSynth.extension = -1;
 }
 
 void DisplacementsWidget::DoSmoothing()
@@ -240,7 +270,7 @@ void DisplacementsWidget::DoSmoothing()
 	printf("\n\nInitializing Displacement Field... (grid size :%d)\n", grid_square_size->value());
 
 	df = new Displacements(workingMesh, this->skeleton, num_smooth_steps->value(), 
-		num_iteration->value(), step_size->value(), volume_preserve->isChecked());
+		num_iteration->value(), step_size->value(), volume_preserve->isChecked(), SmoothRegion());
 
 	UpdateDF(df);
 
@@ -252,21 +282,35 @@ void DisplacementsWidget::DoSmoothing()
 	QApplication::restoreOverrideCursor();
 }
 
+Vector<int> DisplacementsWidget::SmoothRegion()
+{
+	// Smoothing only the selected part, when asked and there is a selection
+	if(smooth_selection->isChecked() && skeleton->sortedSelectedNodes.size() > 1)
+		return skeleton->getSelectedFaces(true);
+
+	return Vector<int>();
+}
+
 void DisplacementsWidget::CreateDF()
 {
 	int numSteps = num_smooth_steps->value();
 	int numIter = num_iteration->value();
 	double stepSize = step_size->value();
+	unsigned int meshVersion = SmoothStairway::meshVersion(sourceMesh);
+	Vector<int> region = SmoothRegion();
 
-	// Check if smoothing not done or changed, if so re-smooth
+	// Check if smoothing not done or changed, if so re-smooth.
+	// Levels already computed for these settings come from the stairway cache.
 	if(!df || numSteps != prevSmooth.numSteps || numIter != prevSmooth.numIter 
-		|| stepSize != prevSmooth.stepSize)
+		|| stepSize != prevSmooth.stepSize || meshVersion != prevSmooth.meshVersion || region != prevSmooth.region)
 	{
 		DoSmoothing();
 
 		prevSmooth.numSteps = numSteps;
 		prevSmooth.stepSize = stepSize;
 		prevSmooth.numIter = numIter;
+		prevSmooth.meshVersion = meshVersion;
+		prevSmooth.region = region;
 	}
 
 	if(skeleton->sortedSelectedNodes.size() < 2)
@@ -353,6 +397,41 @@ void DisplacementsWidget::DirectSynthesize()
 	Vector<Vec> path = user_curve->getPath( df->GetGrid()->segmentLength );
 	int expectedExtension = path.size() - 1;
 
+	SynthSettings synth;
+	synth.type = synthesisType->currentText();
+	synth.crop = cropArea;
+	synth.extension = expectedExtension;
+	synth.blockSize = block_size->value();
+	synth.bandSize = band_size->value();
+	synth.options = synthCrossSections->isChecked() | (blendCrossSections->isChecked() << 1) 
+		| (changeProfile->isChecked() << 2) | (fillSeams->isChecked() << 3) 
+		| (blendSeams->isChecked() << 4) | (sampleSeams->isChecked() << 5);
+	synth.curve = user_curve->spline.GetPoints();
+
+	// Only the curve was edited: keep the synthesized texture and patches, move them
+	bool isCurveOnly = !firstGridMesh && gmesh.size() && synth.type != "Stretch" 
+		&& sameSynthesis(synth, prevSynth) && !sameCurve(synth.curve, prevSynth.curve);
+
+	prevSynth = synth;
+
+	if(isCurveOnly)
+	{
+		printf(".Same synthesis, new curve.\n");
+
+		mainWindow->ui.viewer->makeCurrent();
+
+		gmesh.back().updateCurve(user_curve->getSpline());
+
+		// Compare the next edit against the curve as the extension aligned it
+		prevSynth.curve = user_curve->spline.GetPoints();
+
+		AttachExtension(&gmesh.back());
+
+		QString timeAsString; timeAsString.sprintf("Extension moved. (%.2f s)", ((int)allTimer.elapsed()) / 1000.0f);
+		Print(timeAsString, 1000);
+		return;
+	}
+
 	stats["textureSynthesis"] = Stats("Texture Synthesis");
 
 	TextureSynthesizer ts;
@@ -364,6 +443,16 @@ void DisplacementsWidget::DirectSynthesize()
 		textureSynthResult = ts.synthesizeAsPos(grid, (src.rows() * bottomPadding),
 			expectedExtension, block_size->value(), band_size->value());
 	}
+	else if(synthesisType->currentText() == "Multi-resolution")
+	{
+		textureSynthResult = ts.pyramidAsPos(grid, (src.rows() * bottomPadding),
+			expectedExtension, block_size->value(), band_size->value());
+	}
+	else if(synthesisType->currentText() == "Coherence (PatchMatch)")
+	{
+		textureSynthResult = ts.coherenceAsPos(grid, (src.rows() * bottomPadding),
+			expectedExtension, block_size->value());
+	}
 	else if(synthesisType->currentText() == "Nearest-neighbor interpolation") // bad..
 	{
 		textureSynthResult = ts.resampleAsPos(grid, expectedExtension);
@@ -379,6 +468,9 @@ void DisplacementsWidget::DirectSynthesize()
 
 	stats["textureSynthesis"].end();
 
+	// Kept for streaming the extension out
+	synthResult = textureSynthResult;
+
 	// Timing for Texture synthesis
 	printf(".Done (%d ms)", (int)textureTimer.elapsed());
 
@@ -428,6 +520,9 @@ void DisplacementsWidget::DirectSynthesize()
 	// for cleaner code
 	GridMesh * gm = &gmesh.back();
 
+	// The extension aligns the curve in place, remember it as aligned
+	prevSynth.curve = user_curve->spline.GetPoints();
+
 	// Show cross-section and large scale detail synthesized result
 	csExtendedImage->setPixmap( pixmapFromMatrix(gm->extendedSections) );
 	//lsExtendedImage->setPixmap( QPixmap::fromImage(imageFromMatrix(resizeAsImage(ls_pattern, ls_pattern.cols() * 5), true)) );
@@ -436,12 +531,34 @@ void DisplacementsWidget::DirectSynthesize()
 	gm->testPoints.push_back(midSkeleton->n1->v());
 	gm->testPoints.push_back(midSkeleton->n2->v());
 
-	// Now modify mesh
-	Mesh * m = getMesh("LoadedMesh");
-
 	// Timing
 	printf("\n\nDone (%d ms)\n==========\n\n", (int)extentionTimer.elapsed());
 
+	AttachExtension(gm);
+
+	QString timeAsString; timeAsString.sprintf("Synthesis Done. (%.2f s)", ((int)allTimer.elapsed()) / 1000.0f);
+	Print(timeAsString, 1000);
+
+	stats["extendAmount"] = Stats("Amount of extension", 100.0 * ((float)textureSynthResult[0].size() / grid.cols()));
+
+	// Preview texture synthesis result
+	outputImage->setPixmap(QPixmap::fromImage(ts.imageOutput()));
+
+	// Output debug images:
+	QImage q (imageFromMatrix(grid));
+	q.save("_input_texture.bmp");
+	outputImage->pixmap()->save("_output_texture.bmp");
+	tempImage = q;
+
+	crossSectionImage->pixmap()->save("_input_cross-section.bmp");
+	csExtendedImage->pixmap()->save("_output_cross-section.bmp");
+}
+
+void DisplacementsWidget::AttachExtension(GridMesh * gm)
+{
+	// Now modify mesh
+	Mesh * m = getMesh("LoadedMesh");
+
 	CreateTimer(sliceTimer);
 	printf("Slicing and moving..");
 
@@ -501,23 +618,6 @@ void DisplacementsWidget::DirectSynthesize()
 	mainWindow->ui.viewer->update();
 
 	printf("done remaining (%d ms). Synthesize extension Done.\n", (int)otherTimer.elapsed());
-
-	QString timeAsString; timeAsString.sprintf("Synthesis Done. (%.2f s)", ((int)allTimer.elapsed()) / 1000.0f);
-	Print(timeAsString, 1000);
-
-	stats["extendAmount"] = Stats("Amount of extension", 100.0 * ((float)textureSynthResult[0].size() / grid.cols()));
-
-	// Preview texture synthesis result
-	outputImage->setPixmap(QPixmap::fromImage(ts.imageOutput()));
-
-	// Output debug images:
-	QImage q (imageFromMatrix(grid));
-	q.save("_input_texture.bmp");
-	outputImage->pixmap()->save("_output_texture.bmp");
-	tempImage = q;
-
-	crossSectionImage->pixmap()->save("_input_cross-section.bmp");
-	csExtendedImage->pixmap()->save("_output_cross-section.bmp");
 }
 
 void DisplacementsWidget::Triangulate()
@@ -690,6 +790,47 @@ void DisplacementsWidget::Triangulate()
 
 }
 
+void DisplacementsWidget::StreamExtension()
+{
+	if(!df || synthResult.empty() || prevSynth.type == "Stretch")
+	{
+		Print("Nothing to stream, synthesize an extension first.");
+		return;
+	}
+
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Stream Extension"), "", tr("OBJ (*.obj)"));
+	if(fileName.isEmpty()) return;
+
+	MeshWriter writer(fileName.toAscii());
+
+	if(!writer.isOpen())
+	{
+		Print("Could not open " + fileName);
+		return;
+	}
+
+	CreateTimer(streamTimer);
+	Print("Streaming extension..");
+
+	// Make sure viewer is the current OpenGL, the dialog may have changed it
+	mainWindow->ui.viewer->makeCurrent();
+
+	// GridMesh aligns the curve it is given, leave the user's curve alone
+	Spline curve = user_curve->spline;
+
+	// Same settings the last synthesis used
+	unsigned int options = prevSynth.options;
+
+	GridMeshStream stream(df->GetGrid(), prevSynth.crop, &curve, synthResult, options & 1, (options >> 1) & 1, 
+		prevSynth.bandSize, (options >> 2) & 1, (options >> 3) & 1, &writer);
+
+	writer.close();
+
+	QString message; message.sprintf("Streamed %d vertices %d faces. (%.2f s)", writer.numberOfVertices(), 
+		writer.numberOfFaces(), ((int)streamTimer.elapsed()) / 1000.0f);
+	Print(message, 1000);
+}
+
 void DisplacementsWidget::Print(QString message, int age)
 {
 	mainWindow->ui.viewer->print(message, age);
@@ -23,7 +23,10 @@
 
 #include "Slicer.h"
 
-struct SmoothSettings{int numSteps; double stepSize; int numIter;};
+class GridMesh;
+
+struct SmoothSettings{int numSteps; double stepSize; int numIter; unsigned int meshVersion; Vector<int> region;};
+struct SynthSettings{QString type; Rect crop; int extension, blockSize, bandSize; unsigned int options; Vector<Vec> curve;};
 
 class DisplacementsWidget: public QWidget
 {
@@ -45,6 +48,7 @@ private:
 	QDoubleSpinBox * step_size;
 	QSpinBox * num_iteration;
 	QCheckBox * volume_preserve;
+	QCheckBox * smooth_selection;
 
 	QSpinBox * grid_square_size;
 	QComboBox * fitting_method;
@@ -80,6 +84,7 @@ private:
 	QSpinBox * rotate_right;
 	QPushButton * directSynthesize;
 	QPushButton * buttonTriangulate;
+	QPushButton * buttonStreamOutput;
 
 	QDockWidget * resultsWidget;
 	QFrame * resultsFrame;
@@ -100,6 +105,13 @@ private:
 	bool firstGridMesh;
 
 	SmoothSettings prevSmooth;
+	SynthSettings prevSynth;
+	Vector2DPoint synthResult;
+
+	Vector<int> SmoothRegion();
+
+	// Cut the loaded mesh (once) and move its far half to the end of the extension
+	void AttachExtension(GridMesh * gm);
 
 protected:
 	
@@ -126,6 +138,7 @@ public slots:
 	void CreateDF();
 	void DirectSynthesize();
 	void Triangulate();
+	void StreamExtension();
 
 	void Print(QString, int age = 500);
 
@@ -4,6 +4,150 @@
 
 #include "ExtendMeshHeaders.h"
 
+#include <QFile>
+
+// Grid cache file: the header, then the arrays in the order listed
+#define GRID_CACHE_VERSION 2
+
+// Fields stored for each square and point
+#define GRID_SQUARE_FIELDS 11
+#define GRID_POINT_FIELDS 7
+
+struct GridCacheHeader
+{
+	char magic[4];
+	int version;
+	unsigned int key;
+
+	int squareSize, pointSize;		// bytes stored for each GridSquare and GridPoint
+	int widthCount, lengthCount;
+
+	int vertexCount;				// fitted grid vertices, 3 doubles each
+	int frameCount;					// local frames, 9 doubles each
+	int squareCount;				// squares
+	int pointCount;					// points, then parameter and base point of each, 6 doubles
+	int levelCount;					// level heights (levels x squares), then max and min heights
+	int selectedCount;				// selected faces
+};
+
+template <typename T>
+static void writeCache(QFile & file, const T * data, int count)
+{
+	if(count > 0) file.write((const char *)data, qint64(sizeof(T)) * count);
+}
+
+// Copies the next 'count' items out of the mapped file, false if it is short
+template <typename T>
+static bool readCache(const uchar * & at, const uchar * end, T * data, int count)
+{
+	qint64 bytes = qint64(sizeof(T)) * count;
+
+	if(count < 0 || end - at < bytes) return false;
+
+	if(bytes) memcpy(data, at, bytes);
+	at += bytes;
+
+	return true;
+}
+
+// Squares are stored field by field: corners, faces, u v, id, then the point range
+static void writeCache(QFile & file, const GridSquare * squares, int count)
+{
+	Vector<int> fields;
+	fields.reserve(Max(0, count) * GRID_SQUARE_FIELDS);
+
+	for(int i = 0; i < count; i++)
+	{
+		const GridSquare & s = squares[i];
+
+		for(int k = 0; k < 4; k++) fields.push_back(s.p[k]);
+
+		fields.push_back(s.face1);	fields.push_back(s.face2);
+		fields.push_back(s.u);		fields.push_back(s.v);
+		fields.push_back(s.id);
+		fields.push_back(s.pointStart);	fields.push_back(s.pointCount);
+	}
+
+	writeCache(file, fields.empty() ? NULL : &fields[0], fields.size());
+}
+
+static bool readCache(const uchar * & at, const uchar * end, GridSquare * squares, int count)
+{
+	if(count < 0) return false;
+
+	Vector<int> fields(count * GRID_SQUARE_FIELDS);
+
+	if(!readCache(at, end, fields.empty() ? NULL : &fields[0], fields.size())) return false;
+
+	for(int i = 0; i < count; i++)
+	{
+		const int * f = &fields[i * GRID_SQUARE_FIELDS];
+		GridSquare & s = squares[i];
+
+		s.setCorners(f[0], f[1], f[2], f[3]);
+
+		s.face1 = f[4];	s.face2 = f[5];
+		s.setUV(f[6], f[7]);
+		s.id = f[8];
+		s.pointStart = f[9];	s.pointCount = f[10];
+	}
+
+	return true;
+}
+
+// Points are stored as their weights, height and shift, then all the corresponding points
+static void writeCache(QFile & file, const GridPoint * points, int count)
+{
+	Vector<float> fields;
+	Vector<int> corr;
+
+	fields.reserve(Max(0, count) * GRID_POINT_FIELDS);
+	corr.reserve(Max(0, count));
+
+	for(int i = 0; i < count; i++)
+	{
+		const GridPoint & gp = points[i];
+
+		for(int k = 0; k < 4; k++) fields.push_back(gp.w[k]);
+
+		fields.push_back(gp.h);
+		fields.push_back(gp.shiftAngle);
+		fields.push_back(gp.shiftMagnitude);
+
+		corr.push_back(gp.corrPoint);
+	}
+
+	writeCache(file, fields.empty() ? NULL : &fields[0], fields.size());
+	writeCache(file, corr.empty() ? NULL : &corr[0], corr.size());
+}
+
+static bool readCache(const uchar * & at, const uchar * end, GridPoint * points, int count)
+{
+	if(count < 0) return false;
+
+	Vector<float> fields(count * GRID_POINT_FIELDS);
+	Vector<int> corr(count);
+
+	if(!readCache(at, end, fields.empty() ? NULL : &fields[0], fields.size())
+		|| !readCache(at, end, corr.empty() ? NULL : &corr[0], corr.size())) return false;
+
+	for(int i = 0; i < count; i++)
+	{
+		const float * f = &fields[i * GRID_POINT_FIELDS];
+		GridPoint & gp = points[i];
+
+		for(int k = 0; k < 4; k++) gp.w[k] = f[k];
+
+		gp.h = f[4];
+		gp.shiftAngle = f[5];
+		gp.shiftMagnitude = f[6];
+
+		gp.corrPoint = corr[i];
+	}
+
+	return true;
+}
+
 Grid::Grid(Vector<Vec> & src_spine, double radius, double Length, int sizeOfGrid, 
 		   SmoothStairway * Stair, const StdList<Face*>& MeshFaces, int rotateLeft, int rotateRight)
 {
@@ -37,8 +181,7 @@ Grid::Grid(Vector<Vec> & src_spine, double radius, double Length, int sizeOfGrid
 	widthCount = width / gridSquareSize;
 	lengthCount = length / gridSquareSize;
 
-	multiLevelSquares.push_back(Vector<GridSquare>());
-	Vector<GridSquare> * squares = &multiLevelSquares[0];
+	Vector<GridSquare> * squares = &gridSquares;
 
 	squares->reserve(widthCount * lengthCount);
 
@@ -145,10 +288,7 @@ Grid::Grid(Vector<Vec> & src_spine, double radius, double Length, int sizeOfGrid
 			faceToSquare.push_back(sIndex);
 			faceToSquare.push_back(sIndex);
 
-			// Add to squares map
-			indexSquareMap[sIndex] = squares->back();
-			squaresMap[Point(u, v)] = squares->back();
-			squaresIndexMap[Point(u, v)] = sIndex++;
+			sIndex++;
 
 			fIndex += 2;
 		}
@@ -345,11 +485,20 @@ void Grid::Gridify(Vector<int> & selectedMeshFaces)
 	this->max_height = Vector<double>(stair->numberOfSteps(), DBL_MIN);
 	this->min_height = Vector<double>(stair->numberOfSteps(), DBL_MAX);
 
-	Vector<GridSquare> * squares = &multiLevelSquares[0];
-	Vector<int> modifiedSquares;
+	Vector<GridSquare> * squares = &gridSquares;
 
 	int N = activePoints.size();
 
+	// Points that hit a square, where, and the detailed point they stand for.
+	// Projected square by square once all are in
+	Vector<int> hitVertex, hitSquare;
+	Vector<Vec> hitPoint, hitDetailed;
+
+	hitVertex.reserve(N);
+	hitSquare.reserve(N);
+	hitPoint.reserve(N);
+	hitDetailed.reserve(N);
+
 	// Timing
 	CreateTimer(projectionTimer);
 	printf(".(Number of Points = %d).", N);
@@ -371,7 +520,6 @@ void Grid::Gridify(Vector<int> & selectedMeshFaces)
 
 		double minDist = DBL_MAX;
 		Vec pointOnSquare;
-		Vector<double> w(4, 0);
 
 		// Filter points outside our work area
 		if(startPlane.IsFront(detailedPoint) && endPlane.IsFront(detailedPoint))
@@ -426,42 +574,111 @@ void Grid::Gridify(Vector<int> & selectedMeshFaces)
 		// The grid insertion operations
 		if(square)
 		{
-			// Insert point into grid square
-			GridPoint gp = ProjectOnGrid(detailedPoint, pointOnSquare, square, i, w);
-			square->insertPoint(gp);
+			hitVertex.push_back(i);
+			hitSquare.push_back(square->id);
+			hitPoint.push_back(pointOnSquare);
+			hitDetailed.push_back(detailedPoint);
 
 			// Add to map for easy access
-			pointSquareMap[i] = (*square);
-			pointSquareIndexMap[i] = Point(square->u, square->v);
-			pointVecMap[i] = ParameterCoord(w, square->u, square->v);
+			pointSquareMap[i] = square->id;
 			basePoints[i] = basePoint;
 
 			// Save normals of original mesh
 			originalMeshNormals[i] = *stair->mostDetailedMesh()->n(i);
+		}
+	}
 
-			modifiedSquares.push_back(square->id);
+	int hitCount = hitVertex.size();
 
-			// World Records
-			float h = square->points.back().h;
+	// Lay points out by square, in hit order within a square
+	Vector<int> hitAt(hitCount);
 
-			max_height[0] = Max(h, max_height[0]);
-			min_height[0] = Min(h, min_height[0]);
-		}
+	for(int s = 0; s < (int)squares->size(); s++)
+		squares->at(s).pointCount = 0;
+
+	for(int j = 0; j < hitCount; j++)
+		squares->at(hitSquare[j]).pointCount++;
+
+	int pointStart = 0;
+	for(int s = 0; s < (int)squares->size(); s++)
+	{
+		squares->at(s).pointStart = pointStart;
+		pointStart += squares->at(s).pointCount;
+		squares->at(s).pointCount = 0;
 	}
 
-	stats["gridifiy"].end();
+	for(int j = 0; j < hitCount; j++)
+	{
+		GridSquare * square = &squares->at(hitSquare[j]);
+		hitAt[square->pointStart + square->pointCount++] = j;
+	}
 
-	stats["numPoints"] = Stats("Num Points in region", (double)pointSquareMap.size());
+	// Project the points of each square together
+	CreateTimer(mvcTimer);
 
-	// Copy modified squares (so bad.. pointers are better)
-	for(int i = 0; i < (int)modifiedSquares.size(); i++)
+	squarePoints.resize(hitCount, GridPoint(0));
+	Vector<Vec> parameterPoint(hitCount);
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(int s = 0; s < (int)squares->size(); s++)
 	{
-		GridSquare s = squares->at(modifiedSquares[i]);
-		indexSquareMap[modifiedSquares[i]] = s;
-		squaresMap[Point(s.u, s.v)] = s;
+		GridSquare * square = &gridSquares[s];
+
+		int n = square->pointCount;
+		if(!n) continue;
+
+		Vec q[] = {vertex[square->p[0]], vertex[square->p[1]], vertex[square->p[2]], vertex[square->p[3]]};
+
+		// px, py, pz, then the weights of each corner
+		Vector<double> buffer(7 * n);
+		double * px = &buffer[0], * py = px + n, * pz = py + n;
+		double * w[] = {pz + n, pz + 2 * n, pz + 3 * n, pz + 4 * n};
+
+		for(int k = 0; k < n; k++)
+		{
+			const Vec & pointOnSquare = hitPoint[hitAt[square->pointStart + k]];
+
+			px[k] = pointOnSquare.x;
+			py[k] = pointOnSquare.y;
+			pz[k] = pointOnSquare.z;
+		}
+
+		MVC(q, n, px, py, pz, w);
+
+		for(int k = 0; k < n; k++)
+		{
+			int index = square->pointStart + k;
+			int j = hitAt[index];
+
+			double pointWeights[] = {w[0][k], w[1][k], w[2][k], w[3][k]};
+
+			squarePoints[index] = ProjectOnGrid(hitDetailed[j], hitPoint[j], square, hitVertex[j], pointWeights);
+			parameterPoint[index] = ParameterCoord(pointWeights, square->u, square->v);
+		}
 	}
 
-	printf("Point projections done (%d ms).", (int)projectionTimer.elapsed());
+	int mvcTime = Max(1, (int)mvcTimer.elapsed());
+
+	for(int index = 0; index < hitCount; index++)
+	{
+		GridPoint * gp = &squarePoints[index];
+
+		pointIndexMap[gp->corrPoint] = index;
+		pointVecMap[gp->corrPoint] = parameterPoint[index];
+
+		// World Records
+		float h = gp->h;
+
+		max_height[0] = Max(h, max_height[0]);
+		min_height[0] = Min(h, min_height[0]);
+	}
+
+	stats["gridifiy"].end();
+
+	stats["numPoints"] = Stats("Num Points in region", (double)pointSquareMap.size());
+
+	printf("Point projections done (%d ms, %d points/sec on squares).", (int)projectionTimer.elapsed(), 
+		(int)(1000.0 * hitCount / mvcTime));
 
 	CreateTimer(squaresTimer);
 	printf("Computing square values..");
@@ -473,146 +690,331 @@ void Grid::Gridify(Vector<int> & selectedMeshFaces)
 	this->isReady = true;
 }
 
+// Faces of a mesh by index. The face map is a hash map and is not safe to
+// index from several threads, threads read this table instead
+static Vector<BaseTriangle*> facesByIndex(Mesh * m)
+{
+	StdList<Face> * faces = m->facesList();
+
+	int maxIndex = -1;
+	for(StdList<Face>::iterator f = faces->begin(); f != faces->end(); f++)
+		maxIndex = Max(maxIndex, f->index);
+
+	Vector<BaseTriangle*> table(maxIndex + 1, (BaseTriangle*)NULL);
+	for(StdList<Face>::iterator f = faces->begin(); f != faces->end(); f++)
+		table[f->index] = &(*f);
+
+	return table;
+}
+
 void Grid::computeSquareValues()
 {
 	int numberOfLevels = stair->numberOfSteps();
+	int squareCount = gridSquares.size();
+
+	Mesh * mesh = stair->mostDetailedMesh();
 
-	// Prepare multi-level (empty) squares
-	for(int l = 0; l < numberOfLevels - 1; l++)
-		multiLevelSquares.push_back(Vector<GridSquare>(multiLevelSquares[0]));
+	// Level meshes, and a tree over the selected faces of each for rays
+	// that miss the face found on the most detailed mesh
+	Vector<Mesh *> levelMesh(numberOfLevels);
+	Vector<Octree> levelOctree(numberOfLevels);
 
-	Vector<GridSquare> * squares = &multiLevelSquares[0];
+	// Faces are looked up serially, before the parallel loop
+	Vector<BaseTriangle*> detailedFaces = facesByIndex(mesh);
+	Vector<Vector<BaseTriangle*> > levelFaces(numberOfLevels);
 
-	Mesh * mesh = stair->mostDetailedMesh();
-	//Mesh * baseMesh = stair->mostBaseMesh();
+	for(int l = 0; l < numberOfLevels; l++)
+	{
+		levelMesh[l] = stair->getStepDetailed(l);
+		levelFaces[l] = facesByIndex(levelMesh[l]);
+
+		levelOctree[l] = Octree(selectedFaces, levelMesh[l], 20);
+		levelOctree[l].build();
+	}
+
+	// Distance along the square normal at each level, squares are independent
+	Vector<double> sampled(numberOfLevels * squareCount, 0);
+	Vector<char> isSampled(squareCount, 0);
 
 	stats["computeSquares"] = Stats("Compute approximate image");
 
-	// Get multilevel height for each square on the grid
-	for(int s = 0; s < (int)squares->size(); s++)
+	// Shoot ray to base mesh, and find it on detailed surface to get height
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(int s = 0; s < squareCount; s++)
 	{
-		GridSquare * square = &squares->at(s);
+		GridSquare * square = &gridSquares[s];
 		Vec squareNormal = ((fNormal[square->face1] + fNormal[square->face1]) / 2.0).unit();
 
-		//Vector<GridPoint> * points = &square->points;
+		Vec pointOnSquare = PointFromSquare(GridPoint::MidPoint().w, square);
+
+		Ray ray(pointOnSquare, squareNormal);
+		HitResult hitRes, closestHit;
+
+		IndexSet tris;
+
+		// One traversal, its face is tried first on every level
+		BaseTriangle * closestFace = detailed_octree->findClosestTri(ray, tris, detailedFaces, hitRes);
+
+		if(!closestFace) continue;
+
+		int closestIndex = closestFace->index;
 
-		// Average of points (if any) <- this might be a bad choice...
-		/*if(points->size() > 0)
-		{
-		// Multi-level
 		for(int l = 0; l < numberOfLevels; l++)
 		{
-		// for each level compute the height
-		double sum = 0;
+			BaseTriangle * levelFace = (closestIndex < (int)levelFaces[l].size()) ? levelFaces[l][closestIndex] : NULL;
 
-		for(int pIndex = 0; pIndex < points->size(); pIndex++)
-		{
-		GridPoint * p = &points->at(pIndex);
+			if(levelFace)
+				levelFace->intersectionTest(ray, hitRes, true);
+			else
+				hitRes.hit = false;
 
-		Vec detailedPoint = *stair->getStepDetailed(l)->v(p->corrPoint);
+			if(hitRes.hit)
+				closestHit = hitRes;
+			else
+			{
+				// closest face has changed
+				IndexSet levelTris;
 
-		double height = ((squareNormal * SIGN(p->h)) * (detailedPoint - basePoints[p->corrPoint])) * SIGN(p->h);
+				if(levelOctree[l].findClosestTri(ray, levelTris, levelFaces[l], hitRes))
+				{
+					closestIndex = hitRes.index;
+					closestHit = hitRes;
+				}
+			}
 
-		if(l > 0)
-		multiLevelSquares[l][s].getPoint(pIndex)->h = height;
+			sampled[s * numberOfLevels + l] = closestHit.distance;
+		}
 
-		sum += height;
+		isSampled[s] = 1;
+	}
+
+	// Clamp outliers against the running range, in square order
+	levelHeights = MatrixXf::Zero(numberOfLevels, squareCount);
+
+	for(int s = 0; s < squareCount; s++)
+	{
+		if(!isSampled[s])
+		{
+			levelHeights(0, s) = min_height[0];
+			continue;
 		}
 
-		multiLevelSquares[l][s].height = sum / points->size();
+		for(int l = 0; l < numberOfLevels; l++)
+		{
+			double height = sampled[s * numberOfLevels + l];
+
+			if(height > max_height[l] * 5)	height = max_height[l];
+			if(height < min_height[l] * 5)	height = min_height[l];
+
+			levelHeights(l, s) = height;
+
+			max_height[l] = Max(max_height[l], height);
+			min_height[l] = Min(min_height[l], height);
 		}
+	}
+
+	stats["computeSquares"].end();
+}
+
+bool Grid::saveCache(const QString & fileName, unsigned int key)
+{
+	if(!isReady) return false;
+
+	QFile file(fileName);
+
+	if(!file.open(QIODevice::WriteOnly)) return false;
+
+	GridCacheHeader header;
+
+	memcpy(header.magic, "EMGC", 4);
+	header.version = GRID_CACHE_VERSION;
+	header.key = key;
+
+	header.squareSize = GRID_SQUARE_FIELDS * sizeof(int);
+	header.pointSize = GRID_POINT_FIELDS * sizeof(float) + sizeof(int);
+	header.widthCount = widthCount;
+	header.lengthCount = lengthCount;
+
+	header.vertexCount = numberOfVertices();
+	header.frameCount = localFrames.size();
+	header.squareCount = gridSquares.size();
+	header.pointCount = squarePoints.size();
+	header.levelCount = levelHeights.rows();
+	header.selectedCount = selectedFaces.size();
+
+	Vector<double> vertices, frames, pointCoords;
+
+	for(int i = 0; i < header.vertexCount; i++)
+	{
+		vertices.push_back(vertex[i].x);	vertices.push_back(vertex[i].y);	vertices.push_back(vertex[i].z);
+	}
+
+	for(int i = 0; i < header.frameCount; i++)
+	{
+		Vec axis[] = {localFrames[i].n, localFrames[i].up, localFrames[i].b};
+
+		for(int k = 0; k < 3; k++)
+		{
+			frames.push_back(axis[k].x);	frames.push_back(axis[k].y);	frames.push_back(axis[k].z);
 		}
-		else*/
+	}
+
+	for(int i = 0; i < header.pointCount; i++)
+	{
+		int corr = squarePoints[i].corrPoint;
+		Vec coord[] = {pointVecMap[corr], basePoints[corr]};
+
+		for(int k = 0; k < 2; k++)
 		{
-			// Else, Shoot ray to base mesh, and find it on detailed surface to get height
-			Vec pointOnSquare = PointFromSquare(GridPoint::MidPoint().w, square);
+			pointCoords.push_back(coord[k].x);	pointCoords.push_back(coord[k].y);	pointCoords.push_back(coord[k].z);
+		}
+	}
 
-			Ray ray(pointOnSquare, squareNormal);
-			HitResult hitRes, closestHit;
+	file.write((const char *)&header, sizeof(header));
 
-			IndexSet tris;
+	writeCache(file, vertices.empty() ? NULL : &vertices[0], vertices.size());
+	writeCache(file, frames.empty() ? NULL : &frames[0], frames.size());
+	writeCache(file, gridSquares.empty() ? NULL : &gridSquares[0], header.squareCount);
+	writeCache(file, squarePoints.empty() ? NULL : &squarePoints[0], header.pointCount);
+	writeCache(file, pointCoords.empty() ? NULL : &pointCoords[0], pointCoords.size());
+	writeCache(file, levelHeights.data(), levelHeights.size());
+	writeCache(file, max_height.empty() ? NULL : &max_height[0], max_height.size());
+	writeCache(file, min_height.empty() ? NULL : &min_height[0], min_height.size());
+	writeCache(file, selectedFaces.empty() ? NULL : &selectedFaces[0], header.selectedCount);
 
-			BaseTriangle * closestFace = detailed_octree->findClosestTri(ray, tris, mesh, hitRes);
+	bool isSaved = (file.error() == QFile::NoError);
 
-			if(closestFace)
-			{
-				// Multi-level
-				for(int l = 0; l < numberOfLevels; l++)
-				{
-					stair->getStepDetailed(l)->f(closestFace->index)->intersectionTest(ray, hitRes, true);
+	file.close();
 
-					if(hitRes.hit)
-						closestHit = hitRes;
-					else
-					{
-						double minDist = DBL_MAX;
-
-						// closest face has changed
-						foreach(int findex, selectedFaces)
-						{
-							stair->getStepDetailed(l)->f(findex)->intersectionTest(ray, hitRes, true);
-
-							if(hitRes.hit && abs(hitRes.distance) < abs(minDist))
-							{
-								closestFace = mesh->f(findex);
-								minDist = abs(hitRes.distance);
-								closestHit = hitRes;
-							}
-						}
-					}
+	if(!isSaved) file.remove();
 
-					double height = closestHit.distance;
+	return isSaved;
+}
 
-					if(height > max_height[l] * 5)	height = max_height[l];
-					if(height < min_height[l] * 5)	height = min_height[l];
+bool Grid::loadCache(const QString & fileName, unsigned int key)
+{
+	QFile file(fileName);
 
-					multiLevelSquares[l][s].height = height;
+	if(!file.open(QIODevice::ReadOnly)) return false;
 
-					max_height[l] = Max(max_height[l], height);
-					min_height[l] = Min(min_height[l], height);
-				}
-			}
-			else
-			{
-				multiLevelSquares[0][s].height = min_height[0];
-			}
-		}
+	qint64 size = file.size();
+	uchar * data = (size > 0) ? file.map(0, size) : NULL;
+
+	if(!data) return false;
+
+	const uchar * at = data, * end = data + size;
+
+	GridCacheHeader header;
+
+	// Same inputs give the same freshly constructed grid
+	bool isValid = readCache(at, end, &header, 1) && memcmp(header.magic, "EMGC", 4) == 0 
+		&& header.version == GRID_CACHE_VERSION && header.key == key
+		&& header.squareSize == GRID_SQUARE_FIELDS * (int)sizeof(int)
+		&& header.pointSize == GRID_POINT_FIELDS * (int)sizeof(float) + (int)sizeof(int)
+		&& header.widthCount == widthCount && header.lengthCount == lengthCount
+		&& header.vertexCount == numberOfVertices() && header.frameCount == (int)localFrames.size()
+		&& header.squareCount == (int)gridSquares.size() && header.levelCount == stair->numberOfSteps()
+		&& header.pointCount >= 0 && header.selectedCount >= 0;
+
+	Vector<double> vertices, frames, pointCoords;
+	Vector<GridSquare> squares;
+	Vector<GridPoint> points;
+	MatrixXf heights;
+	Vector<double> maxHeight, minHeight;
+	Vector<int> faces;
+
+	if(isValid)
+	{
+		vertices.resize(header.vertexCount * 3);
+		frames.resize(header.frameCount * 9);
+		squares.resize(header.squareCount);
+		points.resize(header.pointCount, GridPoint(0));
+		pointCoords.resize(header.pointCount * 6);
+		heights.resize(header.levelCount, header.squareCount);
+		maxHeight.resize(header.levelCount);
+		minHeight.resize(header.levelCount);
+		faces.resize(header.selectedCount);
+
+		isValid = readCache(at, end, vertices.empty() ? NULL : &vertices[0], vertices.size())
+			&& readCache(at, end, frames.empty() ? NULL : &frames[0], frames.size())
+			&& readCache(at, end, squares.empty() ? NULL : &squares[0], squares.size())
+			&& readCache(at, end, points.empty() ? NULL : &points[0], points.size())
+			&& readCache(at, end, pointCoords.empty() ? NULL : &pointCoords[0], pointCoords.size())
+			&& readCache(at, end, heights.data(), heights.size())
+			&& readCache(at, end, maxHeight.empty() ? NULL : &maxHeight[0], maxHeight.size())
+			&& readCache(at, end, minHeight.empty() ? NULL : &minHeight[0], minHeight.size())
+			&& readCache(at, end, faces.empty() ? NULL : &faces[0], faces.size());
 	}
 
-	stats["computeSquares"].end();
+	file.unmap(data);
+	file.close();
+
+	if(!isValid) return false;
 
-	// Subtract large scale pattern
-	/*for(int s = 0; s < squares->size(); s++)
+	// Fitted grid and its frames
+	for(int i = 0; i < header.vertexCount; i++)
+		vertex[i] = Vec(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+
+	for(int i = 0; i < header.frameCount; i++)
 	{
-	GridSquare * square = &squares->at(s);
-	Vector<GridPoint> * points = &square->points;
+		const double * f = &frames[i * 9];
 
-	double level1_difference = -((multiLevelSquares[1][s].height - min_height[1]));
+		localFrames[i].n = Vec(f[0], f[1], f[2]);
+		localFrames[i].up = Vec(f[3], f[4], f[5]);
+		localFrames[i].b = Vec(f[6], f[7], f[8]);
+	}
+
+	// As Gridify leaves it, octrees are only needed to project points
+	computeNormals();
+	computeBounds();
 
-	for(int i = 0; i < points->size(); i++)
+	for(int v = 0; v < this->lengthCount + 1; v++)	
+		sections[v] = CrossSection(v, this);
+
+	this->selectedFaces = faces;
+	this->max_height = maxHeight;
+	this->min_height = minHeight;
+	this->levelHeights = heights;
+
+	gridSquares.swap(squares);
+	squarePoints.swap(points);
+
+	Mesh * detailed = stair->mostDetailedMesh();
+
+	for(int s = 0; s < header.squareCount; s++)
 	{
-	GridPoint * p = &points->at(i);
-	GridPoint * p_smoothed = multiLevelSquares[1][s].getPoint(i);
+		GridSquare * square = &gridSquares[s];
 
-	//p->h = p->h + level1_difference;
+		for(int index = square->pointStart; index < square->pointStart + square->pointCount; index++)
+		{
+			int corr = squarePoints[index].corrPoint;
+			const double * c = &pointCoords[index * 6];
+
+			pointSquareMap[corr] = square->id;
+			pointIndexMap[corr] = index;
+			pointVecMap[corr] = Vec(c[0], c[1], c[2]);
+			basePoints[corr] = Vec(c[3], c[4], c[5]);
+			originalMeshNormals[corr] = *detailed->n(corr);
+		}
 	}
 
-	//multiLevelSquares[0][s].height += level1_difference;
-	}*/
+	stats["numPoints"] = Stats("Num Points in region", (double)pointSquareMap.size());
+
+	this->isReady = true;
+
+	return true;
 }
 
 Vector2Df Grid::largeScalePattern()
 {
 	Vector2Df result = Vector2Df(widthCount, Vector<float>(lengthCount, 0.0));
 
-	if(multiLevelSquares.size() > 1)
+	if(levelHeights.rows() > 1)
 	{
-		Vector<GridSquare> * level = &multiLevelSquares[1];
-
 		for(int v = 0; v < lengthCount; v++)
 		{
 			for(int u = 0; u < widthCount; u++)
-				result[u][v] = level->at(squaresIndexMap[Point(u,v)]).height - min_height[1];
+				result[u][v] = levelHeights(1, v * widthCount + u) - min_height[1];
 		}
 	}
 
@@ -641,12 +1043,10 @@ Vector2Df Grid::sectionsPattern()
 
 GridSquare * Grid::getSquare(int u, int v)
 {
-	Point p(u,v);
-
-	if(squaresMap.find(p) != squaresMap.end())
-		return &squaresMap[p];
-	else
+	if(gridSquares.empty() || u < 0 || u >= widthCount || v < 0 || v >= lengthCount)
 		return NULL;
+
+	return &gridSquares[v * widthCount + u];
 }
 
 Vec Grid::gridPoint(GridSquare * s, int index)
@@ -656,7 +1056,7 @@ Vec Grid::gridPoint(GridSquare * s, int index)
 
 Vec Grid::gridPointNormal(int point_index, const Vec& U, const Vec& V, const Vec& N)
 {
-	GridSquare * square = getSquare(pointSquareIndexMap[point_index].x, pointSquareIndexMap[point_index].y);
+	GridSquare * square = getSquareOf(point_index);
 
 	Vec myU = (vertex[square->p[1]] - vertex[square->p[0]]).unit();
 	Vec myV = (vertex[square->p[3]] - vertex[square->p[0]]).unit();
@@ -671,9 +1071,17 @@ Vec Grid::gridPointNormal(int point_index, const Vec& U, const Vec& V, const Vec
 	return (tu * U) + (tv * V) + (tn * N);
 }
 
-Vector<GridSquare> * Grid::getSquares(int level)
+Vector<GridSquare> * Grid::getSquares()
+{
+	return &gridSquares;
+}
+
+float Grid::getSquareHeight(int level, int squareIndex)
 {
-	return &multiLevelSquares[level];
+	if(level < levelHeights.rows() && squareIndex < levelHeights.cols())
+		return levelHeights(level, squareIndex);
+	else
+		return 0;
 }
 
 SquareDimension Grid::getSquareDimensions(int u, int v)
@@ -803,7 +1211,7 @@ void Grid::drawAsGrid()
 
 	if(isDrawReconstructedPoints && isReady)
 	{
-		Vector<GridSquare> * squares = &multiLevelSquares[0];
+		Vector<GridSquare> * squares = &gridSquares;
 
 		double heightScale = max_height[0] - min_height[0];
 
@@ -819,12 +1227,13 @@ void Grid::drawAsGrid()
 		for(int s = 0; s < (int)squares->size(); s++)
 		{
 			GridSquare * square = &squares->at(s);
+			SquareFrame frame = frameOf(square);
 
-			for(Vector<GridPoint>::iterator p = square->points.begin(); p != square->points.end(); p++)
+			for(GridPoint * p = pointsOf(square), * end = p + square->pointCount; p != end; p++)
 			{
-				if(activeGridPoint != &(*p))
+				if(activeGridPoint != p)
 				{
-					Vec point = Reconstruct(p->w, square, p->h, p->shiftAngle, p->shiftMagnitude);
+					Vec point = frame.reconstruct(p->w, p->h, p->shiftAngle, p->shiftMagnitude);
 
 					double value = (p->h - this->min_height[0]) / heightScale;
 
@@ -863,13 +1272,15 @@ void Grid::drawAsGrid()
 
 void Grid::drawPointNames()
 {
-	Vector<GridSquare> * squares = &multiLevelSquares[0];
+	Vector<GridSquare> * squares = &gridSquares;
 
 	for(Vector<GridSquare>::iterator square = squares->begin(); square != squares->end(); square++)
 	{
-		for(Vector<GridPoint>::iterator p = square->points.begin(); p != square->points.end(); p++)
+		SquareFrame frame = frameOf(&(*square));
+
+		for(GridPoint * p = pointsOf(&(*square)), * end = p + square->pointCount; p != end; p++)
 		{
-			Vec point = Reconstruct(p->w, &(*square), p->h, p->shiftAngle, p->shiftMagnitude);
+			Vec point = frame.reconstruct(p->w, p->h, p->shiftAngle, p->shiftMagnitude);
 
 			glPushName(p->corrPoint);
 			glBegin(GL_POINTS);
@@ -889,20 +1300,17 @@ void Grid::selectPoint(int index)
 		return;
 	}
 
-	activeGridSquare = getSquare(pointSquareIndexMap[index].x, pointSquareIndexMap[index].y);
+	activeGridSquare = getSquareOf(index);
+	activeGridPoint = getPoint(index);
 
-	for(Vector<GridPoint>::iterator p = activeGridSquare->points.begin(); p != activeGridSquare->points.end(); p++)
+	if(activeGridPoint)
 	{
-		if(p->corrPoint == index)
-		{
-			activeGridPoint = &(*p);
+		GridPoint * p = activeGridPoint;
 
-			printf("\nSelected point (%d) :\n", p->corrPoint);
-			printf("Height: %f \n", p->h);
-			printf("Weights: ( %f ) ( %f ) ( %f ) ( %f ) \n", p->w[0], p->w[1], p->w[2], p->w[3]);
-			printf("Angle (%f) - Magnitude (%f)\n", p->shiftAngle, p->shiftMagnitude);
-			break;
-		}
+		printf("\nSelected point (%d) :\n", p->corrPoint);
+		printf("Height: %f \n", p->h);
+		printf("Weights: ( %f ) ( %f ) ( %f ) ( %f ) \n", p->w[0], p->w[1], p->w[2], p->w[3]);
+		printf("Angle (%f) - Magnitude (%f)\n", p->shiftAngle, p->shiftMagnitude);
 	}
 }
 
@@ -931,60 +1339,105 @@ void Grid::highlightSquare(int u, int v)
 
 GridSquare * Grid::getSquareOf( int vindex )
 {
-	return &this->pointSquareMap[vindex];
+	HashMap<int, int>::iterator it = pointSquareMap.find(vindex);
+
+	if(it != pointSquareMap.end())
+		return &gridSquares[it->second];
+	else
+		return NULL;
+}
+
+GridPoint * Grid::getPoint( int vindex )
+{
+	HashMap<int, int>::iterator it = pointIndexMap.find(vindex);
+
+	if(it != pointIndexMap.end())
+		return &squarePoints[it->second];
+	else
+		return NULL;
+}
+
+GridPoint * Grid::pointsOf( GridSquare * s )
+{
+	if(s->pointCount)
+		return &squarePoints[s->pointStart];
+	else
+		return NULL;
 }
 
 // Mean value coordinates - based on "Mean Value Coordinates" by Michael S. Floater
-void Grid::MVC(const Vec& p, const Vec q[], Vector<double> & w)
+void Grid::MVC(const Vec q[], int count, const double px[], const double py[], const double pz[], double * w[])
 {
-	int n = w.size();
-	int j, prev, next;
+	double edge[4];
+	for(int j = 0; j < 4; j++)
+		edge[j] = (q[(j + 1) % 4] - q[j]).norm();
+
+	// Points on an edge of the quad, and which edge
+	Vector<int> onEdge(count);
 
-	// Border test
-	for(j = 0; j < n; j++)
+	// Inside polygon, no branches. tan(a/2) = sqrt((1 - cos a) / (1 + cos a))
+	for(int i = 0; i < count; i++)
 	{
-		next = (j + 1) % n;
+		double dx[4], dy[4], dz[4], len[4], tanHalf[4];
 
-		if(Vertex::isBetween(p, q[j], q[next], Epsilon))
+		for(int j = 0; j < 4; j++)
 		{
-			double len = (q[j] - q[next]).norm();
+			dx[j] = q[j].x - px[i];
+			dy[j] = q[j].y - py[i];
+			dz[j] = q[j].z - pz[i];
 
-			// clear weights and interpolate between two points
-			w = Vector<double>(n, 0.0);		
+			len[j] = sqrt(dx[j] * dx[j] + dy[j] * dy[j] + dz[j] * dz[j]);
+		}
 
-			double fromj = (p - q[j]).norm();
+		int border = -1;
 
-			w[next] = fromj / len;
-			w[j] = 1 - w[next];
+		for(int j = 3; j >= 0; j--)
+		{
+			int next = (j + 1) % 4;
 
-			return;
+			double cosAngle = (dx[j] * dx[next] + dy[j] * dy[next] + dz[j] * dz[next]) / (len[j] * len[next]);
+			cosAngle = RANGED(-1.0, cosAngle, 1.0);
+
+			tanHalf[j] = sqrt((1.0 - cosAngle) / (1.0 + cosAngle));
+
+			// Border test, first edge wins
+			border = (len[j] + len[next] > edge[j] + Epsilon) ? border : j;
 		}
-	}
 
-	double weightSum = 0.0;
+		double weight[4], weightSum = 0.0;
 
-	// Inside polygon
-	for(j = 0; j < n; j++)
+		for(int j = 0; j < 4; j++)
+		{
+			weight[j] = (tanHalf[(j + 3) % 4] + tanHalf[j]) / len[j];
+			weightSum += weight[j];
+		}
+
+		// Normalize weights
+		for(int j = 0; j < 4; j++)
+			w[j][i] = weight[j] / weightSum;
+
+		onEdge[i] = border;
+	}
+
+	// On an edge, interpolate between its two corners
+	for(int i = 0; i < count; i++)
 	{
-		prev = (j + n-1) % n;
-		next = (j + 1) % n;
+		int j = onEdge[i];
+		if(j < 0) continue;
 
-		double len = (p - q[j]).norm();
+		int next = (j + 1) % 4;
 
-		double tanAlpha = Vertex::halfAlphaTangent(q[prev], p, q[j]);
-		double tanBeta = Vertex::halfAlphaTangent(q[j], p, q[next]);
+		double fromj = (Vec(px[i], py[i], pz[i]) - q[j]).norm();
 
-		w[j] = (tanAlpha + tanBeta) / len;
+		for(int k = 0; k < 4; k++)
+			w[k][i] = 0.0;
 
-		weightSum += w[j];
+		w[next][i] = fromj / edge[j];
+		w[j][i] = 1 - w[next][i];
 	}
-
-	// Normalize weights
-	for(j = 0; j < n; j++)
-		w[j] /= weightSum;
 }
 
-Vec Grid::ParameterCoord( const Vector<double> w, int u, int v )
+Vec Grid::ParameterCoord( const double w[], int u, int v )
 {
 	Vec p;
 
@@ -1016,12 +1469,10 @@ Vec Grid::ParameterCoord( const Vector<double> w, int u, int v )
 }
 
 GridPoint Grid::ProjectOnGrid(const Vec& detailedPoint, const Vec& pointOnSquare, 
-							  GridSquare * square, int corrPoint, Vector<double> & w)
+							  GridSquare * square, int corrPoint, const double w[])
 {
 	Vec q[] = {vertex[square->p[0]], vertex[square->p[1]], vertex[square->p[2]], vertex[square->p[3]]};
 
-	MVC(pointOnSquare, q, w);
-
 	Vec squareNormal = ((fNormal[square->face1] + fNormal[square->face2]) / 2.0).unit();
 
 	// Find height from grid in normal direction
@@ -1038,10 +1489,10 @@ GridPoint Grid::ProjectOnGrid(const Vec& detailedPoint, const Vec& pointOnSquare
 	// Forward direction (used for local frame)
 	double shiftAngle = Vertex::singed_angle(q[3] - q[0], shiftVector, squareNormal);
 
-	return GridPoint (&w[0], height, shiftAngle, shiftMagnitude, corrPoint);
+	return GridPoint (w, height, shiftAngle, shiftMagnitude, corrPoint);
 }
 
-Vec Grid::PointFromSquare(const double w[], GridSquare * square)
+Vec Grid::PointFromSquare(const float w[], GridSquare * square)
 {
 	Vec p;
 
@@ -1055,20 +1506,15 @@ Vec Grid::PointFromSquare(const double w[], GridSquare * square)
 	return p;
 }
 
-Vec Grid::Reconstruct(const double w[], GridSquare * square, double height, double angle, double shift)
+Vec Grid::Reconstruct(const float w[], GridSquare * square, double height, double angle, double shift)
 {
-	Vec squareNormal = ((fNormal[square->face1] + fNormal[square->face2]) / 2.0).unit();
-	Vec pointOnSquare = PointFromSquare(w, square);
-
-	Vec point = pointOnSquare + (height * squareNormal);
-
-	double shiftAngle = angle;
-	double shiftMagnitude = shift;
+	return frameOf(square).reconstruct(w, height, angle, shift);
+}
 
+SquareFrame Grid::frameOf(GridSquare * square)
+{
+	Vec squareNormal = ((fNormal[square->face1] + fNormal[square->face2]) / 2.0).unit();
 	Vec ref = (v(square->p[3])->vec() - v(square->p[0])->vec()).unit();
-	Vec rotatedRef = Rotation(squareNormal, shiftAngle).rotate(ref);
-
-	point += rotatedRef * shiftMagnitude;
 
-	return point;
+	return SquareFrame(vertex[square->p[0]], vertex[square->p[1]], vertex[square->p[2]], vertex[square->p[3]], squareNormal, ref);
 }
@@ -1,12 +1,15 @@
 #ifndef Grid_H
 #define Grid_H
 
+#include <QString>
+
 #include "Mesh.h"
 #include "Plane.h"
 #include "Spline.h"
 
 #include "SmoothStairway.h"
 #include "GridSquare.h"
+#include "SquareFrame.h"
 
 #include "Point.h"
 #include "CrossSection.h"
@@ -30,15 +33,17 @@ private:
 	Vector<int> selectedFaces;
 	HashMap<int, Vec> originalMeshNormals;
 
-	// Square data
-	Vector< Vector<GridSquare> > multiLevelSquares;
-        StdMap<Point, GridSquare> squaresMap;
-        StdMap<Point, int> squaresIndexMap;
-	HashMap<int, GridSquare> indexSquareMap;
+	// Square data, square (u,v) is at v * widthCount + u
+	Vector<GridSquare> gridSquares;
+
+	// Height of each square at each stairway level (levels x squares)
+	MatrixXf levelHeights;
 
-	// Points data
-	HashMap<int, Point> pointSquareIndexMap;
-	HashMap<int, GridSquare> pointSquareMap;
+	// Points data, the points of all squares in one array ordered by square.
+	// Maps go from a mesh vertex to its square and to its point
+	Vector<GridPoint> squarePoints;
+	HashMap<int, int> pointSquareMap;
+	HashMap<int, int> pointIndexMap;
 	HashMap<int, Vec> basePoints;
 	Vector<int> faceToSquare;
 
@@ -80,12 +85,15 @@ public:
 	Vector<Vec> testPoints;
 
 	// ACCESSORS
-	Vector<GridSquare> * getSquares(int level);
+	Vector<GridSquare> * getSquares();
+	float getSquareHeight(int level, int squareIndex);
         GridSquare * getSquare(int u, int v);
 	SquareDimension getSquareDimensions(int u, int v);
 	Vec gridPoint(GridSquare * s, int index);
 	double getHeightRange(int level);
 	GridSquare * getSquareOf(int vindex);
+	GridPoint * getPoint(int vindex);
+	GridPoint * pointsOf(GridSquare * s);
 
 	Vec gridPointNormal(int point_index, const Vec& U, const Vec& V, const Vec& N);
 	Vec gridSquareNormal(int point_index);
@@ -110,16 +118,24 @@ public:
 
 	// Most important method !
 	void Gridify(Vector<int> & selectedMeshFaces);
+
+	// CACHE of the fitted and gridified state, 'key' identifies the inputs.
+	// Loading expects a grid just constructed from those same inputs
+	bool saveCache(const QString & fileName, unsigned int key);
+	bool loadCache(const QString & fileName, unsigned int key);
 	
 	// MEAN VALUE COORDINATES
-	void MVC(const Vec& p, const Vec q[], Vector<double> & w);
-	Vec PointFromSquare(const double w[], GridSquare * square);
-	Vec Reconstruct(const double w[], GridSquare * square, double height, double angle, double shift);
-	Vec ParameterCoord(const Vector<double> w, int u, int v);
-
-	// PROJECT POINT ON GRID
+	// of 'count' points on quad 'q', coordinates and weights as separate
+	// arrays, w[j][i] is the weight of corner j for point i
+	static void MVC(const Vec q[], int count, const double px[], const double py[], const double pz[], double * w[]);
+	Vec PointFromSquare(const float w[], GridSquare * square);
+	Vec Reconstruct(const float w[], GridSquare * square, double height, double angle, double shift);
+	Vec ParameterCoord(const double w[], int u, int v);
+	SquareFrame frameOf(GridSquare * square);
+
+	// PROJECT POINT ON GRID, given its weights on the square
 	GridPoint ProjectOnGrid(const Vec& detailedPoint, const Vec& pointOnSquare, 
-		GridSquare * square, int corrPoint, Vector<double>& w);
+		GridSquare * square, int corrPoint, const double w[]);
 
 	HashMap<int, Vec> pointVecMap;
 
@@ -13,12 +13,36 @@ using namespace Matrixf;
 #include "ExtendMeshHeaders.h"
 
 #include <sstream>
+#include <algorithm>
+#include <omp.h>
 using namespace std;
 
 GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 				   Spline * curve, Vector2DPoint & synthOutput, 
 				   bool isSynthesizeCS,  bool isBlendCrossSections, int bandSize, bool isChangeProfile, 
 				   bool isFillSeams, bool isBlendSeams, bool isSampleSeams)
+{
+	Initialize(src_grid, cropArea, curve, synthOutput, isSynthesizeCS, isBlendCrossSections, bandSize, 
+		isChangeProfile, isFillSeams, isBlendSeams, isSampleSeams);
+
+	// Synthesize geometry!
+	Synthesize(synthOutput);
+
+	// Triangulate
+	Triangulate();
+
+	// Used for blending
+	if(isSampleSeams || isBlendSeams)	
+		CreateFullPatches();
+
+	// Stitch patches together
+	BlendPatches();
+}
+
+void GridMesh::Initialize(Grid * src_grid, const Rect & cropArea,
+				   Spline * curve, Vector2DPoint & synthOutput, 
+				   bool isSynthesizeCS,  bool isBlendCrossSections, int bandSize, bool isChangeProfile, 
+				   bool isFillSeams, bool isBlendSeams, bool isSampleSeams)
 {
 	this->grid = src_grid;
 	this->extensionCurve = curve;
@@ -43,6 +67,79 @@ GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 	splitIndex = start + (ceil(cropArea.width() * 0.5f) - 1);
 	jump = extensionSize + splitIndex;
 
+	CreateCrossSections();
+
+	// Deal with cross-sections shapes
+	if(isSynthesizeCS)
+	{
+		MatrixXf csMatrix = fromVector2Df(grid->sectionsPattern());
+
+		if(isBlendCrossSections)
+		{
+			extendedSections = tileBlendFromMap(csMatrix, bandSize, grid->item_int["tileCount"]);
+		}
+		else
+		{
+			// Correspond cross sections with synthesized patches
+			extendedSections = synthFromMap(csMatrix, synthOutput);
+		}
+	}
+	else
+	{
+		// Interpolate CrossSection shapes
+		extendedSections = resizeAsImage(grid->sectionsPattern(), crossSection.size() + 1, true);
+	}
+
+	if(isCustomProfile)
+	{
+		// Experiment: add randomness
+		float range = extendedSections.array().maxCoeff() - extendedSections.array().minCoeff();
+
+		int rows = extendedSections.rows();
+		int cols = extendedSections.cols();
+
+		MatrixXf pattern = Matrixf::pattern(cols, rows, "smooth-random", 0.2f);
+		//MatrixXf pattern = Matrixf::pattern(cols, rows, "wave", 12);
+
+		pattern.array() *= 0.75;
+
+		extendedSections.array() += (pattern.array() * range);
+
+		/*for(int v = 0; v <= totalWidth; v++)
+		{
+		lastProfileScale = (float) (v * 0.9f) / (totalWidth) ;
+
+		crossSection[v].scaleBy(lastProfileScale);
+		crossSection[v].translate(crossSection[v].getCenter() * (1.0f + (lastProfileScale / 2.0f)));
+		}*/
+	}
+	else
+		lastProfileScale = 1.0f;
+
+	ApplyCrossSections();
+
+	printf("\nStart index = %d \t End index = %d \n", start, end);
+	printf("Split Point = %d \t Extension Size = %d \n", splitIndex, extensionSize);
+	printf("Num cross sections = %d \n\n", crossSection.size());
+
+	isReady = false;
+
+	this->stitcher = NULL;
+	this->recon = NULL;
+	this->blender = NULL;
+
+	// Default render options
+	isDrawWithNormals = true;
+	isDrawCrossSections = false;
+	isDrawTriangulated = false;
+	isDrawColoredPatches = false;
+}
+
+void GridMesh::CreateCrossSections()
+{
+	crossSection.clear();
+	special_cs.clear();
+
 	// Cross-sections at split point 
 	CrossSection c1(splitIndex, grid);
 	CrossSection c2(splitIndex + 1, grid);
@@ -65,18 +162,7 @@ GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 
 	extensionTanget.push_back( extensionTanget.back() );	// last tangent
 
-	for(int it = 0; it < 4; it++){
-		Vector<Vec> smooth = extensionTanget;
-
-		for(int i = 3; i < (int)extensionTanget.size() - 3; i++)
-		{
-			smooth[i] = ((  extensionTanget[i-3] + extensionTanget[i-2] + 
-							extensionTanget[i-1] + extensionTanget[i+3] + 
-							extensionTanget[i+2] + extensionTanget[i+1] ) / 6.0f).unit();
-		}
-
-		extensionTanget = smooth;
-	}
+	LocalFrame::smoothTangent( extensionTanget );
 
 	// Check tangents direction
 	if(extensionTanget.front() * c1.getNormal() < 0)
@@ -85,28 +171,70 @@ GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 			extensionTanget[i] = -extensionTanget[i];
 	}
 
-	// Local frames
-	localFrames = LocalFrame::alongTangent( extensionTanget,  c1.getUp() );
+	// Local frames, and the turn from the first tangent to each
+	Vector<Rotation> turn;
+	localFrames = LocalFrame::alongTangent( extensionTanget,  c1.getUp(), turn );
+
+	// Last synthetic column reached, and first grid row of the real end part
+	int lastE = Min(extensionSize, start + totalWidth - splitIndex);
+	int endStart = Max(start, splitIndex);
+
+	// hack? path continues straight past its end
+	while((int)extensionPath.size() < lastE + 2)
+	{
+		Vec delta = extensionPath.back() - extensionPath[extensionPath.size() - 2];
+
+		extensionPath.push_back(extensionPath.back() + delta);
+		extensionTanget.push_back(extensionTanget.back());
+		localFrames.push_back(localFrames.back());
+		turn.push_back(turn.back());
+	}
 
 	Vec shiftedCenter;
 	Rotation endRotation;
 
-	int e = 0;
-	int vi = start;
-	CrossSection current;
+	if(lastE == extensionSize)
+	{
+		int e = extensionSize;
+
+		modifiedEndCenter = extensionPath[e+1];
+		shiftedCenter = modifiedEndCenter - originalEndCenter;
 
-	// Start the extension process
+		// Find rotation needed to align last cross-sections
+		endRotation = LocalFrame::rotation(localFrames[splitIndex], localFrames[e]);
+
+		// Hack
+		CrossSection nextCS(endStart + 1, grid, Color4(255,50,255));
+		nextCS.rotateAround(originalEndCenter, endRotation);
+		nextCS.translateBy(shiftedCenter);
+		Rotation adjRot(nextCS.getNormal(), localFrames[e+1].n);
+
+		endRotation = adjRot * endRotation;
+	}
+
+	// Synthetic parts repeat the last real start one, turned along the path
+	CrossSection last(splitIndex - 1, grid);
+	Rotation toPath(last.getNormal(), extensionTanget.front().unit());
+
+	crossSection.resize(totalWidth + 1);
+
+	// Start the extension process, each column on its own
+	#pragma omp parallel for
 	for(int v = start; v < totalWidth + start + 1; v++)
 	{
+		int e = v - splitIndex;
+
+		CrossSection current;
+
 		if(v < splitIndex)
 		{
 			// Real start part
-			current = CrossSection(vi++, grid, Color4(255,50,50)); // red
+			current = CrossSection(v, grid, Color4(255,50,50)); // red
 		}
 		else if(e > extensionSize)
 		{
 			// Real end part
-			current = CrossSection(vi++, grid, Color4(255,50,255)); // purple
+			current = CrossSection(endStart + e - extensionSize - 1, grid, Color4(255,50,255)); // purple
 
 			current.rotateAround(originalEndCenter, endRotation);
 			current.translateBy(shiftedCenter);
@@ -114,103 +242,33 @@ GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 		else
 		{
 			// Synthetic parts
-			current = CrossSection(0, crossSection.back(), crossSection.back(), Color4(50,255,50)); // green-ish
-
-			// hack?
-			if(e+1 >= (int)extensionPath.size())
-			{
-				Vec delta = extensionPath.back() - extensionPath[extensionPath.size() - 2];
+			current = CrossSection(0, last, last, Color4(50,255,50)); // green-ish
 
-				extensionPath.push_back(extensionPath.back() + delta);
-				extensionTanget.push_back(extensionTanget.back());
-				localFrames.push_back(localFrames.back());
-			}
-
-			current.align( extensionTanget[e] );
+			current.rotate( turn[e] * toPath );
 			current.translate( extensionPath[e] );
-
-			if(e == extensionSize)
-			{
-				modifiedEndCenter = extensionPath[e+1];
-				shiftedCenter = modifiedEndCenter - originalEndCenter;
-
-				// Find rotation needed to align last cross-sections
-				endRotation = LocalFrame::rotation(localFrames[splitIndex], localFrames[e]);
-
-				// Hack
-				CrossSection nextCS(vi+1, grid, Color4(255,50,255));
-				nextCS.rotateAround(originalEndCenter, endRotation);
-				nextCS.translateBy(shiftedCenter);
-				Rotation adjRot(nextCS.getNormal(), localFrames[e+1].n);
-
-				endRotation = adjRot * endRotation;
-			}
-
-			e++;
 		}
 
 		// Add it to GridMesh
-		crossSection.push_back(current);
-
-		// Add special cross-sections
-		if (v == splitIndex - 1 || v == splitIndex + extensionSize)
-		{
-			special_cs.push_back(current);
-		}
+		crossSection[v - start] = current;
 	}
 
-	// Deal with cross-sections shapes
-	if(isSynthesizeCS)
-	{
-		MatrixXf csMatrix = fromVector2Df(grid->sectionsPattern());
-
-		if(isBlendCrossSections)
-		{
-			extendedSections = tileBlendFromMap(csMatrix, bandSize, grid->item_int["tileCount"]);
-		}
-		else
-		{
-			// Correspond cross sections with synthesized patches
-			extendedSections = synthFromMap(csMatrix, synthOutput);
-		}
-	}
-	else
-	{
-		// Interpolate CrossSection shapes
-		extendedSections = resizeAsImage(grid->sectionsPattern(), crossSection.size() + 1, true);
-	}
-
-	if(isCustomProfile)
+	// Add special cross-sections
+	for(int v = start; v < totalWidth + start + 1; v++)
 	{
-		// Experiment: add randomness
-		float range = extendedSections.array().maxCoeff() - extendedSections.array().minCoeff();
-
-		int rows = extendedSections.rows();
-		int cols = extendedSections.cols();
-
-		MatrixXf pattern = Matrixf::pattern(cols, rows, "smooth-random", 0.2f);
-		//MatrixXf pattern = Matrixf::pattern(cols, rows, "wave", 12);
-
-		pattern.array() *= 0.75;
-
-		extendedSections.array() += (pattern.array() * range);
-
-		/*for(int v = 0; v <= totalWidth; v++)
-		{
-		lastProfileScale = (float) (v * 0.9f) / (totalWidth) ;
-
-		crossSection[v].scaleBy(lastProfileScale);
-		crossSection[v].translate(crossSection[v].getCenter() * (1.0f + (lastProfileScale / 2.0f)));
-		}*/
+		if (v == splitIndex - 1 || v == splitIndex + extensionSize)
+			special_cs.push_back(crossSection[v - start]);
 	}
-	else
-		lastProfileScale = 1.0f;
+}
 
+void GridMesh::ApplyCrossSections()
+{
 	// Apply cross-section pattern
 	for(int v = 0; v < (int)crossSection.size(); v++)
 		crossSection[v].setLengths(column(v, extendedSections));
 
 	// add the squares coordinates
+	c.clear();
+
 	int cIndex = 0;
 
 	for(int v = 0; v < totalWidth; v++)
@@ -228,95 +286,80 @@ GridMesh::GridMesh(Grid * src_grid, const Rect & cropArea,
 			cIndex += 4;
 		}
 	}
+}
 
-	printf("\nStart index = %d \t End index = %d \n", start, end);
-	printf("Split Point = %d \t Extension Size = %d \n", splitIndex, extensionSize);
-	printf("Num cross sections = %d \n\n", crossSection.size());
+void GridMesh::Synthesize(Vector<Vector<Point> > & synthOutput)
+{
+	stats["reconstruction"] = Stats("Reconstruction");
 
-	isReady = false;
+	MapCells(synthOutput);
 
-	this->stitcher = NULL;
-	this->recon = NULL;
-	this->blender = NULL;
+	this->synthPatchCopy = synth;
 
-	// Default render options
-	isDrawWithNormals = true;
-	isDrawCrossSections = false;
-	isDrawTriangulated = false;
-	isDrawColoredPatches = false;
+	// For each square, reconstruct all points
+	Vector<int> cells(totalHeight * totalWidth);
 
-	// Synthesize geometry!
-	Synthesize(synthOutput);
+	for(int cell = 0; cell < (int)cells.size(); cell++)
+		cells[cell] = cell;
 
-	// Triangulate
-	Triangulate();
+	int countRecon = ReconstructCells(cells);
 
-	// Used for blending
-	if(isSampleSeams || isBlendSeams)	
-		CreateFullPatches();
+	printf(".Reconstructed %d points.\n", countRecon);
 
-	// Stitch patches together
-	BlendPatches();
+	isReady = true;
 }
 
-void GridMesh::Synthesize(Vector<Vector<Point> > & synthOutput)
+void GridMesh::MapCells(Vector<Vector<Point> > & synthOutput)
 {
-	stats["reconstruction"] = Stats("Reconstruction");
-
 	this->synth = synthOutput;
-
 	this->synthPatch = synth;
-	this->synthPatchCopy = synth;
 
-	int synth_u, synth_v;
+	int cellCount = totalHeight * totalWidth;
 
-	GridSquare * src_square;
+	// Source square of each cell from the synthesis process output
+	cellSquare = Vector<GridSquare *>(cellCount, (GridSquare *)NULL);
+	reconOffset = Vector<int>(cellCount, 0);
 
-	// Copy square info from the synthesis process output
 	for(int v = 0; v < totalWidth; v++)
-	{
 		for(int u = 0; u < totalHeight; u++)
-		{
-			synth_v = synth[u][v].x;
-			synth_u = synth[u][v].y;
+			cellSquare[cellIndex(u, v)] = grid->getSquare(synth[u][v].y, synth[u][v].x + start);
+}
 
-			src_square = grid->getSquare(synth_u, synth_v + start);
+int GridMesh::ReconstructCells(const Vector<int> & cells)
+{
+	int cellCount = cells.size();
+	int countRecon = 0;
 
-			if(src_square)
-			{
-				square[u][v].points = src_square->points;
-				square[u][v].pointIndices = src_square->pointIndices;
+	// Where each cell's points go in the flat buffer
+	for(int i = 0; i < cellCount; i++)
+	{
+		int cell = cells[i];
 
-				square[u][v].id = src_square->id;
-				square[u][v].u = src_square->u;
-				square[u][v].v = src_square->v;
-			}
-		}
+		reconOffset[cell] = countRecon;
+		countRecon += cellSquare[cell] ? cellSquare[cell]->pointCount : 0;
 	}
 
-	// Reconstruction of elements
-	recon_points = Vector<Vector<HashMap<int, Vec> > >(totalHeight, Vector<HashMap<int, Vec> >(totalWidth));
-
-	int countRecon = 0;
+	reconX.resize(countRecon);
+	reconY.resize(countRecon);
+	reconZ.resize(countRecon);
 
-	// For each square, reconstruct all points
-	for(int v = 0; v < totalWidth; v++)
+	// Cells write disjoint ranges
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int i = 0; i < cellCount; i++)
 	{
-		for(int u = 0; u < totalHeight; u++)
-		{
-			for(Vector<GridPoint>::iterator p = square[u][v].points.begin(); p != square[u][v].points.end(); p++)
-			{
-				Vec point = Reconstruct(p->w, &square[u][v], p->h, p->shiftAngle, p->shiftMagnitude);
+		int cell = cells[i];
 
-				// Used for triangulation
-				recon_points[u][v][p->corrPoint] = point;
+		GridSquare * src_square = cellSquare[cell];
+		if(!src_square || !src_square->pointCount) continue;
 
-				countRecon++;
-			}
-		}
+		GridSquare * target_square = &square[cell % totalHeight][cell / totalHeight];
+
+		int j = reconOffset[cell];
+
+		frameOf(target_square).reconstruct(grid->pointsOf(src_square), src_square->pointCount, &reconX[j], &reconY[j], &reconZ[j]);
 	}
 
-	isReady = true;
+	return countRecon;
 }
 
 
@@ -326,6 +369,15 @@ void GridMesh::Triangulate()
 
 	getAllPatches();
 
+	TriangulatePatches(0);
+
+	isDrawTriangulated = true;
+
+	stats["reconstruction"].end();
+}
+
+void GridMesh::TriangulatePatches(int first)
+{
 	Mesh * mesh = grid->getBaseMesh();
 
 	// Copying triangulation from mesh
@@ -334,51 +386,118 @@ void GridMesh::Triangulate()
 	// Get triangles that are in current patch
 	Vector<int> faces = *grid->getSelectedFaces();
 
-	int v0, v1, v2;
-	Face * f;
+	int faceCount = faces.size();
+	int patchCount = tri_patch.size();
+	int vertexCount = mesh->numberOfVertices();
 
-	// For each patch
-	for(int w = 0; w < (int)tri_patch.size(); w++)
-	{
-		IntSet patchPoints;	// store points in this patch
+	// Patch points, and every (vertex, patch) pair once. A source square can
+	// be synthesized into several patches, so can its vertices
+	Vector<int> lastPatch(vertexCount, -1);
+	Vector<std::pair<int, int> > membership;
 
-		// Get the points indices from patch's squares
+	for(int w = first; w < patchCount; w++)
+	{
 		for(Vector<SimpleSquare>::iterator it = tri_patch[w].patch.begin(); it != tri_patch[w].patch.end(); it++)
 		{
-			GridSquare * currSquare = &square[it->u][it->v];
+			int cell = cellIndex(it->u, it->v);
+			GridSquare * currSquare = cellSquare[cell];
 
-			for(Vector<int>::iterator q = currSquare->pointIndices.begin(); q != currSquare->pointIndices.end(); q++)
+			if(currSquare)
 			{
-				patchPoints.insert(*q);
+				GridPoint * points = grid->pointsOf(currSquare);
+
+				for(int j = 0, i = reconOffset[cell]; j < currSquare->pointCount; j++, i++)
+				{
+					int q = points[j].corrPoint;
+
+					tri_patch[w].insertPoint(q, reconPoint(i), i);
 
-				tri_patch[w].insertPoint(*q, recon_points[it->u][it->v][*q]);
+					if(lastPatch[q] != w)
+					{
+						lastPatch[q] = w;
+						membership.push_back(std::make_pair(q, w));
+					}
+				}
 			}
 
 			it->parentPatch = w;
 		}
+	}
+
+	// Patches of each vertex, ascending: vertexPatch[vertexStart[v] .. vertexStart[v + 1])
+	Vector<int> vertexStart(vertexCount + 1, 0);
+	Vector<int> vertexPatch(membership.size());
+
+	for(int i = 0; i < (int)membership.size(); i++) vertexStart[membership[i].first + 1]++;
+	for(int v = 0; v < vertexCount; v++) vertexStart[v + 1] += vertexStart[v];
 
-		// If all points of a face is within this patch, include these points
-		for(int findex = 0; findex < (int)faces.size(); findex++)
+	Vector<int> fill(vertexStart.begin(), vertexStart.end() - 1);
+	for(int i = 0; i < (int)membership.size(); i++) vertexPatch[fill[membership[i].first]++] = membership[i].second;
+
+	// Face corners, looked up once
+	Vector<int> corners(faceCount * 3);
+
+	for(int findex = 0; findex < faceCount; findex++)
+	{
+		Face * f = mesh->f(faces[findex]);
+
+		for(int k = 0; k < 3; k++)
+			corners[findex * 3 + k] = f->vIndex[k];
+	}
+
+	// One sweep over faces: a face goes to every patch holding all three of its
+	// corners, a corner alone is non-triangulated in its patch. Each thread
+	// fills its own buckets over a contiguous range of faces, so per patch
+	// the buckets in thread order keep the faces in order.
+	// Entries are face indices, or -1 - vertex for non-triangulated points
+	int threads = omp_get_max_threads();
+	Vector<Vector<Vector<int> > > bucket(threads, Vector<Vector<int> >(patchCount));
+
+	#pragma omp parallel
+	{
+		Vector<Vector<int> > & threadBucket = bucket[omp_get_thread_num()];
+
+		#pragma omp for schedule(static)
+		for(int findex = 0; findex < faceCount; findex++)
 		{
-			f = mesh->f(faces[findex]);
+			const int * corner = &corners[findex * 3];
+
+			for(int k = 0; k < 3; k++)
+			{
+				int v = corner[k];
 
-			v0 = f->vIndex[0];
-			v1 = f->vIndex[1];
-			v2 = f->vIndex[2];
+				for(int i = vertexStart[v]; i < vertexStart[v + 1]; i++)
+				{
+					int w = vertexPatch[i];
 
-			bool v0_ok = patchPoints.has(v0);
-			bool v1_ok = patchPoints.has(v1);
-			bool v2_ok = patchPoints.has(v2);
+					bool isInside = true;
 
-			bool face_ok = v0_ok && v1_ok && v2_ok;
+					for(int j = 1; j < 3 && isInside; j++)
+					{
+						int o = corner[(k + j) % 3];
+						isInside = std::binary_search(vertexPatch.begin() + vertexStart[o], vertexPatch.begin() + vertexStart[o + 1], w);
+					}
 
-			if(face_ok)
-				tri_patch[w].insertFace(v0, v1, v2);
-			else
+					if(!isInside)
+						threadBucket[w].push_back(-1 - v);
+					else if(k == 0)
+						threadBucket[w].push_back(findex);
+				}
+			}
+		}
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int w = first; w < patchCount; w++)
+	{
+		for(int t = 0; t < threads; t++)
+		{
+			for(Vector<int>::iterator e = bucket[t][w].begin(); e != bucket[t][w].end(); e++)
 			{
-				if(v0_ok) tri_patch[w].insertNonTriangulated(v0);
-				if(v1_ok) tri_patch[w].insertNonTriangulated(v1);
-				if(v2_ok) tri_patch[w].insertNonTriangulated(v2);
+				if(*e >= 0)
+					tri_patch[w].insertFace(corners[*e * 3], corners[*e * 3 + 1], corners[*e * 3 + 2]);
+				else
+					tri_patch[w].insertNonTriangulated(-1 - *e);
 			}
 		}
 	}
@@ -388,14 +507,10 @@ void GridMesh::Triangulate()
 
 	// Create patches as triangulated meshes
 	#pragma omp parallel for
-	for(int w = 0; w < (int)tri_patch.size(); w++)
+	for(int w = first; w < (int)tri_patch.size(); w++)
 		tri_patch[w].makeMesh();
 
 	printf(".Finalizing patches. (%d ms)\n", (int)patchTimer.elapsed());
-
-	isDrawTriangulated = true;
-
-	stats["reconstruction"].end();
 }
 
 void GridMesh::BlendPatches()
@@ -426,6 +541,72 @@ void GridMesh::BlendPatches()
 	stats["stitching"].end();
 }
 
+void GridMesh::updateCurve(Spline * curve)
+{
+	CreateTimer(timer);
+
+	this->extensionCurve = curve;
+
+	CreateCrossSections();
+	ApplyCrossSections();
+
+	// Same cells and points as before, on the moved squares
+	Vector<int> cells(totalHeight * totalWidth);
+
+	for(int cell = 0; cell < (int)cells.size(); cell++)
+		cells[cell] = cell;
+
+	ReconstructCells(cells);
+
+	// Patch vertices follow their points
+	#pragma omp parallel for
+	for(int w = 0; w < (int)tri_patch.size(); w++)
+	{
+		MeshPatch * patch = &tri_patch[w];
+
+		for(int k = 0; k < (int)patch->vertexSource.size(); k++)
+		{
+			if(patch->vertexSource[k] >= 0)
+				patch->mesh.ver(k) = reconPoint(patch->vertexSource[k]);
+		}
+	}
+
+	// Stitched extension keeps its seam faces, seam smoothing is not redone
+	Mesh * M = &triangluatedExtension;
+
+	if(M->numberOfVertices() && (int)extensionSource.size() == M->numberOfVertices())
+	{
+		for(int k = 0; k < (int)extensionSource.size(); k++)
+		{
+			if(extensionSource[k] >= 0)
+				M->ver(k) = reconPoint(extensionSource[k]);
+		}
+
+		M->computeNormals();
+		M->rebuildVBO();
+	}
+
+	// Full patches and blending are computed from positions all over
+	if(isSampleSeams || isBlendSeams)
+	{
+		CreateFullPatches();
+
+		if(isSampleSeams)
+		{
+			delete recon;
+			recon = new Reconstructor(this);
+		}
+
+		if(isBlendSeams)
+		{
+			delete blender;
+			blender = new Blender(this);
+		}
+	}
+
+	printf(".Curve updated (%d ms).\n", (int)timer.elapsed());
+}
+
 void GridMesh::CreateFullPatches()
 {
 	printf("\nfp b/d Mesh(es)..");
@@ -449,28 +630,62 @@ void GridMesh::CreateFullPatches()
 		tri_patch[w].fpdMesh = Mesh(n);
 	}
 
-	// Create full patch meshes
+	// Shared by all patches: full patch vertices, their grid square and
+	// point, and the faces with corners as indices into the vertex list
+	Vector<int> fpVerts(fullPatchVerts.begin(), fullPatchVerts.end());
+	Vector<GridSquare *> fpSquare(n);
+	Vector<GridPoint *> fpPoint(n);
+	Vector<Vec> fpParameter(isSampleSeams ? n : 0);
+
+	HashMap<int, int> fpIndex;
+
+	for(int vi = 0; vi < n; vi++)
+	{
+		int corr = fpVerts[vi];
+
+		fpSquare[vi] = grid->getSquareOf(corr);
+		fpPoint[vi] = grid->getPoint(corr);
+
+		if(isSampleSeams)
+			fpParameter[vi] = grid->pointVecMap[fpPoint[vi]->corrPoint];
+
+		fpIndex[corr] = vi;
+	}
+
+	Vector<int> fpFaces;
+	fpFaces.reserve(fullPatchFaces.size() * 3);
+
+	for(StdSet<Face*>::iterator f = fullPatchFaces.begin(); f != fullPatchFaces.end(); f++)
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			HashMap<int, int>::iterator it = fpIndex.find((*f)->vIndex[k]);
+			fpFaces.push_back(it != fpIndex.end() ? it->second : -1);
+		}
+	}
+
+	int faceCount = fpFaces.size() / 3;
+
+	// Create full patch meshes, patches are independent
+	#pragma omp parallel for schedule(dynamic)
 	for(int i = 0; i < (int)tri_patch.size(); i++)
 	{
 		SimpleSquare start = fullPatchStarts[i];
 
-		// Add vertices for full patch mesh
-		VertexMap vertsMap;
-		StdSet<int>::iterator fpvi = fullPatchVerts.begin();
+		// Add vertices for full patch mesh, vertsMap is -1 for unused vertices
+		Vector<int> vertsMap(n, -1);
 		int vIndex = 0;
 
 		Vector<Vec> parameterPoint;
 
 		for(int vi = 0; vi < n; vi++)
 		{
-			int corr = *(fpvi++);
-
-			GridSquare * squareInGrid = grid->getSquareOf(corr);
+			GridSquare * squareInGrid = fpSquare[vi];
 			GridSquare * squareInGridMesh = getSquareFromStart(squareInGrid->u, start.src_u, squareInGrid->v, start.src_v);
 
 			if(squareInGridMesh != NULL)
 			{
-				GridPoint * p = squareInGrid->getPointCorr(corr);
+				GridPoint * p = fpPoint[vi];
 
 				Vec point = PointFromSquare(p->w, squareInGridMesh);
 
@@ -480,13 +695,13 @@ void GridMesh::CreateFullPatches()
 				if(isSampleSeams)
 				{
 					// Parameter points
-					Vec uvPos = grid->pointVecMap[p->corrPoint];
+					Vec uvPos = fpParameter[vi];
 					uvPos.x = (start.src_v) + (uvPos.x * grid->lengthCount);
 					uvPos.y = (start.src_u) + (uvPos.y * grid->widthCount);
 					parameterPoint.push_back(uvPos);
 				}
 
-				vertsMap[corr] = vIndex++;
+				vertsMap[vi] = vIndex++;
 			}
 		}
 
@@ -495,15 +710,18 @@ void GridMesh::CreateFullPatches()
 
 		// Add faces for full patch mesh
 		int fi = 0;
-		for(StdSet<Face*>::iterator f = fullPatchFaces.begin(); f != fullPatchFaces.end(); f++)
+		for(int findex = 0; findex < faceCount; findex++)
 		{
-			if(MAP_HAS(vertsMap, (*f)->vIndex[0]) && MAP_HAS(vertsMap, (*f)->vIndex[1]) && 
-				MAP_HAS(vertsMap, (*f)->vIndex[2]))
-			{
-				int vi1 = vertsMap[(*f)->vIndex[0]];
-				int vi2 = vertsMap[(*f)->vIndex[1]];
-				int vi3 = vertsMap[(*f)->vIndex[2]];
+			const int * corner = &fpFaces[findex * 3];
+
+			if(corner[0] < 0 || corner[1] < 0 || corner[2] < 0) continue;
 
+			int vi1 = vertsMap[corner[0]];
+			int vi2 = vertsMap[corner[1]];
+			int vi3 = vertsMap[corner[2]];
+
+			if(vi1 >= 0 && vi2 >= 0 && vi3 >= 0)
+			{
 				tri_patch[i].fpbMesh.addFace(vi1, vi2, vi3, fi);
 				tri_patch[i].fpdMesh.addFace(vi1, vi2, vi3, fi);
 
@@ -553,6 +771,8 @@ void GridMesh::getAllPatches()
 {
 	CreateTimer(timer);
 
+	patchScan = 0;
+
 	Vector<SimpleSquare> curr_patch = getNextPatch();
 
 	int maxNumVerts = grid->getSelectedFaces()->size() * 3;
@@ -591,10 +811,11 @@ Vector<SimpleSquare> GridMesh::getNextPatch()
 {
 	Vector<SimpleSquare> result;
 
-	for(int v = 0; v < totalWidth; v++){
+	for(int v = patchScan; v < totalWidth; v++){
 		for(int u = 0; u < totalHeight; u++){
 			if(synthPatch[u][v].x >= 0 && synthPatch[u][v].y >= 0)
 			{
+				patchScan = v;
 				findAllSquaresInPatch(result, u, v);
 				return result;
 			}
@@ -859,7 +1080,7 @@ GridSquare * GridMesh::getSquareFromStart(int src_u, int start_u, int src_v, int
 		return NULL;
 }
 
-Vec GridMesh::PointFromSquare(const double w[], GridSquare * square)
+Vec GridMesh::PointFromSquare(const float w[], GridSquare * square)
 {
 	Vec p;
 
@@ -876,7 +1097,12 @@ Vec GridMesh::PointFromSquare(const double w[], GridSquare * square)
 	return p;
 }
 
-Vec GridMesh::Reconstruct(const double w[], GridSquare * square, float height, float angle, float shift)
+Vec GridMesh::Reconstruct(const float w[], GridSquare * square, float height, float angle, float shift)
+{
+	return frameOf(square).reconstruct(w, height, angle, shift);
+}
+
+SquareFrame GridMesh::frameOf(GridSquare * square)
 {
 	Vec v1 = (c[square->p[1]] - c[square->p[0]]).unit();
 	Vec v2 = (c[square->p[3]] - c[square->p[0]]).unit();
@@ -884,19 +1110,7 @@ Vec GridMesh::Reconstruct(const double w[], GridSquare * square, float height, f
 	Vec squareNormal = (v1 ^ v2).unit();
 	//Vec squareNormal = ((fNormal[square->face1] + fNormal[square->face2]) / 2.0f).unit();
 
-	Vec pointOnSquare = PointFromSquare(w, square);
-
-	Vec point = pointOnSquare + (height * squareNormal);
-
-	float shiftAngle = angle;
-	float shiftMagnitude = shift;
-
-	Vec ref = v2;
-	Vec rotatedRef = Rotation(squareNormal, shiftAngle).rotate(ref);
-
-	point += rotatedRef * shiftMagnitude;
-
-	return point;
+	return SquareFrame(c[square->p[0]], c[square->p[1]], c[square->p[2]], c[square->p[3]], squareNormal, v2);
 }
 
 Rotation GridMesh::lastRotation()
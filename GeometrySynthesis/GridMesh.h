@@ -44,8 +44,9 @@ protected:
 	int jump;
 	int splitPrev, splitIndex, splitNext;
 
-	Vec PointFromSquare(const double w[], GridSquare * square);
-	Vec Reconstruct(const double w[], GridSquare * square, float height, float angle, float shift);
+	Vec PointFromSquare(const float w[], GridSquare * square);
+	Vec Reconstruct(const float w[], GridSquare * square, float height, float angle, float shift);
+	SquareFrame frameOf(GridSquare * square);
 	Vec SquareNormal( GridSquare * square );
 
 	Grid * grid;
@@ -65,6 +66,7 @@ protected:
 	// Patch extraction routines, from synthesized image
 	void getAllPatches();
 	Vector<SimpleSquare> getNextPatch();
+	int patchScan;							// columns before it hold no new patch
 	void findAllSquaresInPatch(Vector<SimpleSquare> & ids, int u, int v);
 	void CreateFullPatches();
 
@@ -72,7 +74,20 @@ protected:
 	Vector<Vector<SimpleSquare> > unroll(const Vector<SimpleSquare> & patch, int & start_x, int & start_y);
 	Vector<SimpleSquare> findPatchBorders( const Vector<Vector<SimpleSquare> > & patch, int thickness = 1);
 
-	Vector<Vector<HashMap<int, Vec> > > recon_points; // reconstructed points
+	// Source square of each synthesized cell, cells are v * totalHeight + u
+	Vector<GridSquare *> cellSquare;
+	inline int cellIndex(int u, int v) { return v * totalHeight + u; }
+	void MapCells(std::vector<std::vector<Point> > & synthOutput);
+
+	// Reconstructed points, flat: a cell's points start at reconOffset[cell]
+	// in the order of its source square's points
+	Vector<int> reconOffset;
+	Vector<double> reconX, reconY, reconZ;
+	inline Vec reconPoint(int i) { return Vec(reconX[i], reconY[i], reconZ[i]); }
+	int ReconstructCells(const Vector<int> & cells);
+
+	// Triangulates patches from 'first' on, their cells reconstructed
+	void TriangulatePatches(int first);
 
 	// Extension properties
 	Vector<Vec> extensionPath;
@@ -85,6 +100,19 @@ protected:
 	// Triangulation
 	MeshPatch findPatches();
 
+	// Cross-sections along the extension and the squares between them
+	void Initialize(Grid * src_grid, const Rect & cropArea,
+		Spline * curve, std::vector<std::vector<Point> > & synthOutput,
+		bool isSynthesizeCS,  bool isBlendCrossSections, int bandSize, bool isChangeProfile, 
+		bool isFillSeams, bool isBlendSeams, bool isSampleSeams);
+
+	// Curve dependent part: frames along the curve, then squares between them
+	void CreateCrossSections();
+	void ApplyCrossSections();
+
+	// Reconstructed point of each vertex of the stitched extension, -1 if unknown
+	Vector<int> extensionSource;
+
 public:
 	GridMesh(Grid * src_grid, const Rect & cropArea,
 		Spline * curve, std::vector<std::vector<Point> > & synthOutput,
@@ -97,6 +125,10 @@ public:
 	void Triangulate();
 	void BlendPatches();
 
+	// Places the same synthesized points along a new curve of the same
+	// length, patches and seams keep their triangulation
+	void updateCurve(Spline * curve);
+
 	// End transformation & cut points
 	Transformation endTransform();
 	void findCutPoints();
@@ -0,0 +1,166 @@
+#include "GridMeshStream.h"
+
+#include "Stitcher.h"
+
+GridMeshStream::GridMeshStream(Grid * src_grid, const Rect & cropArea, Spline * curve, 
+							   std::vector<std::vector<Point> > & synthOutput, bool isSynthesizeCS, 
+							   bool isBlendCrossSections, int bandSize, bool isChangeProfile, 
+							   bool isFillSeams, MeshWriter * writer, int chunkColumns)
+{
+	Initialize(src_grid, cropArea, curve, synthOutput, isSynthesizeCS, isBlendCrossSections, bandSize, 
+		isChangeProfile, isFillSeams, false, false);
+
+	this->writer = writer;
+
+	MapCells(synthOutput);
+
+	Stream(Max(1, chunkColumns));
+}
+
+void GridMeshStream::Stream(int chunkColumns)
+{
+	CreateTimer(timer);
+
+	int maxNumVerts = grid->getSelectedFaces()->size() * 3;
+	int chunkCount = 0;
+
+	patchScan = 0;
+
+	Vector<SimpleSquare> next = getNextPatch();
+
+	while(next.size())
+	{
+		// Patches starting within the chunk's columns, after the carried one
+		int first = tri_patch.size();
+		int chunkEnd = next.front().v + chunkColumns;
+
+		Vector<int> cells;
+
+		while(next.size() && next.front().v < chunkEnd)
+		{
+			tri_patch.push_back(MeshPatch(maxNumVerts, tri_patch.size()));
+			tri_patch.back().patch = next;
+
+			for(Vector<SimpleSquare>::iterator it = next.begin(); it != next.end(); it++)
+				cells.push_back(cellIndex(it->u, it->v));
+
+			next = getNextPatch();
+		}
+
+		ReconstructCells(cells);
+		TriangulatePatches(first);
+
+		// Patches without faces have nothing to stitch
+		for(int w = first; w < (int)tri_patch.size(); w++)
+		{
+			if(tri_patch[w].mesh.numberOfVertices() == 0)
+				tri_patch.erase(tri_patch.begin() + w--);
+			else
+				tri_patch[w].id = w;
+		}
+
+		bool isLast = next.empty();
+
+		if(tri_patch.size() < 2 && !isLast) continue;
+
+		// Stitch the chunk, the carried patch comes first. Chunks are written, never drawn
+		if(tri_patch.size() > 1)
+			stitcher = new Stitcher(this, isFillSeams, false);
+		else if(tri_patch.size())
+			triangluatedExtension = tri_patch.front().mesh;
+		else
+			triangluatedExtension = Mesh();
+
+		Flush(isLast);
+
+		delete stitcher;
+		stitcher = NULL;
+
+		chunkCount++;
+	}
+
+	triangluatedExtension = Mesh();
+
+	printf("\n.Streamed %d chunks, %d vertices %d faces (%d ms).\n", chunkCount, 
+		writer->numberOfVertices(), writer->numberOfFaces(), (int)timer.elapsed());
+}
+
+void GridMeshStream::Flush(bool isLast)
+{
+	Mesh * M = &triangluatedExtension;
+
+	int n = M->numberOfVertices();
+
+	// The last patch still has its seam with the next chunk open, it was merged last
+	int carried = isLast ? 0 : tri_patch.back().mesh.numberOfVertices();
+	int keep = n - carried;
+
+	Vector<int> written(keep);
+
+	for(int i = 0; i < keep; i++)
+		written[i] = writer->addVertex(M->vec(i));
+
+	// Faces left from the previous chunk, the patch they waited on is first in M
+	for(int i = 0; i < (int)pendingFaces.size(); i += 3)
+	{
+		int v[3];
+
+		for(int k = 0; k < 3; k++)
+		{
+			int corner = pendingFaces[i + k];
+			v[k] = (corner < 0) ? -1 - corner : written[corner];
+		}
+
+		writer->addFace(v[0], v[1], v[2]);
+	}
+
+	pendingFaces.clear();
+
+	Mesh held(carried);
+
+	for(int i = keep; i < n; i++)
+		held.addVertex(M->vec(i), i - keep);
+
+	for(StdList<Face>::iterator f = M->facesList()->begin(); f != M->facesList()->end(); f++)
+	{
+		if(f->flag == FF_INVALID_VINDEX || f->VIndex(0) == -1) continue;
+
+		int v[3], heldCorners = 0;
+
+		for(int k = 0; k < 3; k++)
+		{
+			v[k] = f->vIndex[k];
+			if(v[k] >= keep) heldCorners++;
+		}
+
+		if(heldCorners == 0)
+		{
+			writer->addFace(written[v[0]], written[v[1]], written[v[2]]);
+		}
+		else if(heldCorners == 3)
+		{
+			held.addFace(v[0] - keep, v[1] - keep, v[2] - keep, held.numberOfFaces());
+		}
+		else
+		{
+			for(int k = 0; k < 3; k++)
+				pendingFaces.push_back((v[k] >= keep) ? v[k] - keep : -1 - written[v[k]]);
+		}
+	}
+
+	// Carry the last patch, as stitched so far, into the next chunk
+	if(!isLast)
+	{
+		MeshPatch carriedPatch = tri_patch.back();
+
+		carriedPatch.id = 0;
+		carriedPatch.mesh = held;
+
+		tri_patch.clear();
+		tri_patch.push_back(carriedPatch);
+	}
+	else
+	{
+		tri_patch.clear();
+	}
+}
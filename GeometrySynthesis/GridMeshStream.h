@@ -0,0 +1,27 @@
+#pragma once
+
+#include "GridMesh.h"
+#include "MeshWriter.h"
+
+// Builds the extension a chunk of patches at a time along the curve and
+// writes each stitched chunk out. Only the chunk's points and patches are in
+// memory, plus its last patch whose seam with the next chunk is still open.
+// Seam sampling and blending need every patch at once and are not done here.
+class GridMeshStream : public GridMesh
+{
+private:
+	MeshWriter * writer;
+
+	// Faces zipped between written vertices (as -1 - index) and the carried
+	// patch (its own index), written with the carried patch
+	Vector<int> pendingFaces;
+
+	void Stream(int chunkColumns);
+	void Flush(bool isLast);
+
+public:
+	GridMeshStream(Grid * src_grid, const Rect & cropArea,
+		Spline * curve, std::vector<std::vector<Point> > & synthOutput,
+		bool isSynthesizeCS,  bool isBlendCrossSections, int bandSize, bool isChangeProfile, 
+		bool isFillSeams, MeshWriter * writer, int chunkColumns = 64);
+};
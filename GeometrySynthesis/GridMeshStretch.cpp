@@ -54,19 +54,7 @@ GridMeshStretch::GridMeshStretch( Grid * src_grid, const Rect & cropArea, Spline
 	extensionPath.push_back( extensionPath.back() + (extensionPath.back()-extensionPath[extensionPath.size() - 2]) );
 	extensionTanget.push_back( extensionTanget.back() );	// last tangent
 
-	for(int it = 0; it < 4; it++)
-	{
-		Vector<Vec> smooth = extensionTanget;
-
-		for(int i = 3; i < (int)extensionTanget.size() - 3; i++)
-		{
-			smooth[i] = ((  extensionTanget[i-3] + extensionTanget[i-2] + 
-				extensionTanget[i-1] + extensionTanget[i+3] + 
-				extensionTanget[i+2] + extensionTanget[i+1] ) / 6.0f).unit();
-		}
-
-		extensionTanget = smooth;
-	}
+	LocalFrame::smoothTangent( extensionTanget );
 
 	// Check tangents direction
 	if(extensionTanget.front() * c1.getNormal() < 0)
@@ -5,9 +5,11 @@ class GridPoint
 private:
 	
 public:
-	double w[4];
+	// Stored as float, 32 bytes a point. Weights are in [0,1] and the
+	// angle in [-pi,pi] so single precision is plenty
+	float w[4];
 	float h;
-	double shiftAngle;
+	float shiftAngle;
 	float shiftMagnitude;
 	int corrPoint;
 
@@ -54,16 +56,16 @@ public:
 		return *this;
 	}
 
-	GridPoint(double weights[], float height, double shift_angle, float shift_magnitude, int correspondingPoint = -1)
+	GridPoint(const double weights[], float height, double shift_angle, float shift_magnitude, int correspondingPoint = -1)
 	{
-		w[0] = weights[0];
-		w[1] = weights[1];
-		w[2] = weights[2];
-		w[3] = weights[3];
+		w[0] = (float)weights[0];
+		w[1] = (float)weights[1];
+		w[2] = (float)weights[2];
+		w[3] = (float)weights[3];
 
 		h = height;
 		
-		shiftAngle = shift_angle;
+		shiftAngle = (float)shift_angle;
 		shiftMagnitude = shift_magnitude;
 
 		corrPoint = correspondingPoint;
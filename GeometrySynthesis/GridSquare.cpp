@@ -76,25 +76,3 @@ Vector<Vector<double> > GridSquare::uniformSample(int size)
 
 	return samples;
 }
-
-GridPoint * GridSquare::getPointCorr( int corrIndex )
-{
-	for(Vector<GridPoint>::iterator it = points.begin(); it != points.end(); it++)
-	{
-		if(it->corrPoint == corrIndex)
-			return &(*it);
-	}
-
-	return NULL;
-}
-
-double * GridSquare::getWeights( int corrIndex )
-{
-	for(Vector<GridPoint>::iterator it = points.begin(); it != points.end(); it++)
-	{
-		if(it->corrPoint == corrIndex)
-			return it->w;
-	}
-
-	return NULL;
-}
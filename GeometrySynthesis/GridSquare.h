@@ -21,10 +21,9 @@ public:
 
 	int u, v;
 
-	float height;
-
-	std::vector<GridPoint> points;
-	std::vector<int> pointIndices;
+	// Points of the square are [pointStart, pointStart + pointCount) in the
+	// grid's point array, squares are cheap to copy
+	int pointStart, pointCount;
 
 	GridSquare()
 	{
@@ -32,7 +31,7 @@ public:
 		p[0] = p[1] = p[2] = p[3] = -1;
 		face1 = face2 = -1;
 		u = v = -1;
-		height = 0.0f;
+		pointStart = pointCount = 0;
 	}
 
 	GridSquare(int v1, int v2, int v3, int v4, int f1, int f2, int u, int v, int ID)
@@ -50,7 +49,7 @@ public:
 		this->u = u;
 		this->v = v;
 
-		this->height = 0;
+		this->pointStart = this->pointCount = 0;
 	}
 
 	GridSquare(const GridSquare& fromSquare)
@@ -68,10 +67,8 @@ public:
 		this->u = fromSquare.u;
 		this->v = fromSquare.v;
 
-		this->points = fromSquare.points;
-		this->pointIndices = fromSquare.pointIndices;
-
-		this->height = fromSquare.height;
+		this->pointStart = fromSquare.pointStart;
+		this->pointCount = fromSquare.pointCount;
 	}
 
 	GridSquare& operator= (const GridSquare& fromSquare) 
@@ -89,25 +86,12 @@ public:
 		this->u = fromSquare.u;
 		this->v = fromSquare.v;
 
-		this->points = fromSquare.points;
-		this->pointIndices = fromSquare.pointIndices;
-
-		this->height = fromSquare.height;
+		this->pointStart = fromSquare.pointStart;
+		this->pointCount = fromSquare.pointCount;
 
 		return *this;
 	}
 
-	inline void insertPoint(GridPoint & p)
-	{
-		points.push_back(p);
-		pointIndices.push_back(p.corrPoint);
-	}
-
-	inline GridPoint* getPoint(int index)
-	{
-		return &points[index];
-	}
-
 	inline void setUV(int toU, int toV)
 	{
 		this->u = toU;
@@ -122,9 +106,6 @@ public:
 		this->p[3] = v4;
 	}
 
-	GridPoint * getPointCorr( int corrIndex );
-	double * getWeights(int corrIndex);
-
 	static std::vector<std::vector<double> > uniformSample(int size = 3);
 
 };
@@ -58,14 +58,14 @@ void GridVisualizer::computeSquaresValues()
 {
 	squareValue = MatrixXf::Constant(grid->widthCount, grid->lengthCount, FLT_MIN);
 
-	Vector<GridSquare> * squares = grid->getSquares( selectedLevel );
+	Vector<GridSquare> * squares = grid->getSquares();
 
 	for(Vector<GridSquare>::iterator square = squares->begin(); square != squares->end(); square++)
 	{
 		int u = square->u;
 		int v = square->v;
 
-		squareValue(u,v) = square->height;
+		squareValue(u,v) = grid->getSquareHeight(selectedLevel, square->id);
 	}
 }
 
@@ -84,16 +84,16 @@ void GridVisualizer::computePoints()
 	{
 		double heightScale = grid->getHeightRange( 0 );
 
-		Vector<GridSquare> * squares = grid->getSquares( selectedLevel );
+		Vector<GridSquare> * squares = grid->getSquares();
 
 		// For each square on the grid
 		for(Vector<GridSquare>::iterator square = squares->begin(); square != squares->end(); square++)
 		{
 			// Get collection of points
-			Vector<GridPoint> * points = &square->points;
+			GridPoint * points = grid->pointsOf(&(*square));
 
 			// For each point in the square
-			for(Vector<GridPoint>::iterator p = points->begin(); p != points->end(); p++)
+			for(GridPoint * p = points; p != points + square->pointCount; p++)
 			{
 				// Color value
 				double value = (p->h - grid->min_height[selectedLevel]) / heightScale;
@@ -272,21 +272,21 @@ void GridVisualizer::drawGridPoints()
 		glPointSize(pointSize);
 		glBegin(GL_POINTS);
 
-		Vector<GridSquare> * squares = grid->getSquares( selectedLevel );
+		Vector<GridSquare> * squares = grid->getSquares();
 
 		// For each square on the grid
 		for(Vector<GridSquare>::iterator square = squares->begin(); square != squares->end(); square++)
 		{
 			// Get collection of points
-			Vector<GridPoint> * points = &square->points;
+			GridPoint * points = grid->pointsOf(&(*square));
 
 			// For each point in the square
-			for(Vector<GridPoint>::iterator p = points->begin(); p != points->end(); p++)
+			for(GridPoint * p = points; p != points + square->pointCount; p++)
 			{
 				// Color value
 				double value = pointColorMap[p->corrPoint].r();
 
-				if(grid->activeGridSquare == &(*square) && grid->activeGridPoint == &(*p))
+				if(grid->activeGridSquare == &(*square) && grid->activeGridPoint == p)
 					glColor3f(1, value / 2.0, value / 2.0);
 				else
 					glColor3f(value, value, value);
@@ -309,7 +309,7 @@ void GridVisualizer::drawSquareAverage()
 	{
 		glBegin(GL_QUADS);
 
-		Vector<GridSquare> * squares = grid->getSquares( selectedLevel );
+		Vector<GridSquare> * squares = grid->getSquares();
 
 		double heightScale = grid->getHeightRange( 0 );
 
@@ -480,7 +480,7 @@ void GridVisualizer::mousePressEvent(QMouseEvent * e)
 {
 	if(e->button() == Qt::LeftButton)
 	{
-		Vector<GridSquare> * squares = grid->getSquares( selectedLevel );
+		Vector<GridSquare> * squares = grid->getSquares();
 
 		int x_count = grid->lengthCount;
 		int y_count = grid->widthCount;
@@ -510,14 +510,14 @@ void GridVisualizer::mousePressEvent(QMouseEvent * e)
 
 				// debug
 				printf("GridSquare (u = %d, v = %d), Points Count (%d), Height (%f)\n", square->u, 
-					square->v, square->points.size(), square->height);
+					square->v, square->pointCount, grid->getSquareHeight(selectedLevel, square->id));
 
 				if(Mode == GRID_POINTS)
 				{
-					Vector<GridPoint> * points = &square->points;
+					GridPoint * points = grid->pointsOf(&(*square));
 
 					// Find exact point
-					for(Vector<GridPoint>::iterator p = points->begin(); p != points->end(); p++)
+					for(GridPoint * p = points; p != points + square->pointCount; p++)
 					{
 						int h = pointSize / 2.0f;
 
@@ -532,7 +532,7 @@ void GridVisualizer::mousePressEvent(QMouseEvent * e)
 						
 						if(isInRectangle(e->x(), e->y(), r))
 						{
-							grid->activeGridPoint = &(*p);
+							grid->activeGridPoint = p;
 							break;
 						}
 					}
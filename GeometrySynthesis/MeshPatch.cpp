@@ -11,11 +11,12 @@ MeshPatch::MeshPatch(int numVerts, int ID)
 	falseColor = Color4::random();
 }
 
-void MeshPatch::insertPoint(int corrPointIndex, const Vec& pos)
+void MeshPatch::insertPoint(int corrPointIndex, const Vec& pos, int source)
 {
 	int vindex = vertex.size();
 
 	corrPoint[vindex] = corrPointIndex;
+	pointSource[vindex] = source;
 
 	vertex[corrPointIndex] = vindex;
 
@@ -91,6 +92,7 @@ void MeshPatch::makeMesh()
 		usedPointsMap[oldIndex] = newIndex;
 
 		usedIndexToCorr[newIndex] = corrPoint[oldIndex];
+		vertexSource.push_back(pointSource[oldIndex]);
 
 		// Add to mesh structure
 		mesh.addVertex(cloud[oldIndex], newIndex);
@@ -103,7 +105,7 @@ void MeshPatch::makeMesh()
 	}
 }
 
-void MeshPatch::replaceMesh( Mesh * from, bool isReplaceCorr )
+void MeshPatch::replaceMesh( Mesh * from, bool isReplaceCorr, const Vector<int> * oldIndex )
 {
 	KDTree points(3);
 	Vector<int> border;
@@ -122,6 +124,19 @@ void MeshPatch::replaceMesh( Mesh * from, bool isReplaceCorr )
 
 	mesh = *from;
 
+	// Sources follow the vertices when we know where they went
+	Vector<int> oldSource = vertexSource;
+	vertexSource = Vector<int>(mesh.numberOfVertices(), -1);
+
+	if(oldIndex)
+	{
+		for(int i = 0; i < (int)oldIndex->size() && i < (int)vertexSource.size(); i++)
+		{
+			int old = (*oldIndex)[i];
+			if(old >= 0 && old < (int)oldSource.size()) vertexSource[i] = oldSource[old];
+		}
+	}
+
 	// Replace corresponding points
 	if(isReplaceCorr)
 	{
@@ -16,6 +16,7 @@ public:
 
 	VertexMap vertex;
 	VertexMap corrPoint;
+	VertexMap pointSource;
 
 	HashMap<int, Vec> cloud;
 	StdSet<int> nonTriangulated;
@@ -42,6 +43,9 @@ public:
 	Mesh mesh;
 	Color4 falseColor;
 
+	// Reconstructed point each mesh vertex came from, -1 if unknown
+	Vector<int> vertexSource;
+
 	// Full patch structures (for overlapping)
 	Mesh fpbMesh; /* full patch base mesh (fpb-mesh) */
 	Mesh fpdMesh; /* detailed */
@@ -55,13 +59,13 @@ public:
         void drawparameterTris();
 	Vector<Vector<Vec> > readyToDrawTris();
 
-	void insertPoint(int corrPointIndex, const Vec& pos);
+	void insertPoint(int corrPointIndex, const Vec& pos, int source = -1);
 	void insertFace(int cp1, int cp2, int cp3);
 
 	void insertNonTriangulated(int cp);
 
 	void makeMesh();
-	void replaceMesh(Mesh * from, bool isReplaceCorr);
+	void replaceMesh(Mesh * from, bool isReplaceCorr, const Vector<int> * oldIndex = NULL);
 
         void drawPointCloud();
 };
@@ -10,6 +10,7 @@ void Seam::FindSeams(GridMesh * gm, Mesh* & M, Vector<int> & comulativeNumV, Vec
 
 	// Everything will be merged into mesh M, i.e. first patch
 	*M = Mesh(tri_patch->at(0).mesh);
+	gm->extensionSource = tri_patch->at(0).vertexSource;
 
 	Mesh *A, *B;
 	Vector<int> borderA, borderB;
@@ -42,14 +43,15 @@ void Seam::FindSeams(GridMesh * gm, Mesh* & M, Vector<int> & comulativeNumV, Vec
 				int startFace = B->numberOfFaces() * 0.5;
 
 				Vector<int> subFaces = SET_TO_VECTOR(B->getManifoldFaces(startFace));
-				Mesh * cleaned = B->CloneSubMesh(subFaces);
+				Vector<int> oldIndex;
+				Mesh * cleaned = B->CloneSubMesh(subFaces, false, "", &oldIndex);
 
 				bool isLastPart = false;
 
 				if(p == (int)tri_patch->size() - 2)
 					isLastPart = true;
 
-				patch2->replaceMesh(cleaned, isLastPart);
+				patch2->replaceMesh(cleaned, isLastPart, &oldIndex);
 
 				B = &patch2->mesh;
 
@@ -96,6 +98,7 @@ void Seam::FindSeams(GridMesh * gm, Mesh* & M, Vector<int> & comulativeNumV, Vec
 		closestBoundryB.push_back(closestB + comulativeNumV.back());
 
 		M->mergeWith(*B);
+		gm->extensionSource.insert(gm->extensionSource.end(), patch2->vertexSource.begin(), patch2->vertexSource.end());
 
 		borderA = borderB;
 	}
@@ -2,63 +2,218 @@
 
 #include "SimpleDraw.h"
 
-SmoothStairway::SmoothStairway(Mesh * sourceMesh, int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve)
+// Unused chains kept around so earlier settings come back instantly
+#define MAX_CACHED_CHAINS 8
+
+StdList<SmoothStairway::Chain *> SmoothStairway::cache;
+
+SmoothStairway::SmoothStairway(Mesh * sourceMesh, int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve,
+							   const Vector<int> & regionFaces)
 {
 	this->source = sourceMesh;
-	this->step.reserve(numberSteps);
-
 	this->numSteps = numberSteps;
 
-	// Optimization ?
-	this->source->tempUmbrellas.reserve(source->numberOfVertices());
-	this->source->getUmbrellas();
+	this->chain = acquireChain(sourceMesh, numIteration, smoothStepSize, isVolumePreserve, regionFaces);
 
-	// First step is special
-	step.push_back( SmoothStep(source, smoothStepSize, numIteration, isVolumePreserve) );
+	int cachedSteps = chain->steps.size();
 
-	// Create steps
-	for(int i = 0; i < numSteps - 1; i++)
-	{
-		step.push_back( SmoothStep ( step[i].baseMesh(), smoothStepSize, numIteration, isVolumePreserve) );
-	}
+	// Only levels not already in the chain are computed
+	extendChain(chain, numberSteps);
+
+	this->step.reserve(numberSteps);
+
+	for(StdList<SmoothStep>::iterator it = chain->steps.begin(); (int)step.size() < numberSteps; it++)
+		step.push_back(&(*it));
+
+	for(int i = 0; i < (int)step.size(); i++)
+		printf("\nSmoothing step %d: %d solver iterations%s", i, step[i]->numberOfSolverIterations(),
+			(i < cachedSteps) ? " (cached)" : "");
+	printf("\n");
 
 	// Last base is visible
+	for(int i = 0; i < numSteps - 1; i++)
+		getStepBase(i)->isDrawSmooth = source->isDrawSmooth;
 	mostBaseMesh()->isDrawSmooth = false;
 	//mostBaseMesh()->setColor(0, 128, 128, 170);
 
 	this->isDrawDisplacment = true;
+
+	trimCache();
+}
+
+SmoothStairway::SmoothStairway(const SmoothStairway & from)
+{
+	this->chain = NULL;
+	*this = from;
+}
+
+SmoothStairway & SmoothStairway::operator= (const SmoothStairway & from)
+{
+	if(this != &from)
+	{
+		release();
+
+		this->chain = from.chain;
+		this->step = from.step;
+		this->source = from.source;
+		this->numSteps = from.numSteps;
+		this->isDrawDisplacment = from.isDrawDisplacment;
+
+		if(chain) chain->users++;
+	}
+
+	return *this;
+}
+
+SmoothStairway::~SmoothStairway()
+{
+	release();
+}
+
+void SmoothStairway::release()
+{
+	if(chain)
+	{
+		chain->users--;
+		chain = NULL;
+
+		trimCache();
+	}
+
+	step.clear();
+}
+
+SmoothStairway::Chain * SmoothStairway::acquireChain(Mesh * sourceMesh, int numIteration, float smoothStepSize, bool isVolumePreserve,
+													 const Vector<int> & regionFaces)
+{
+	unsigned int version = meshVersion(sourceMesh);
+
+	for(StdList<Chain *>::iterator it = cache.begin(); it != cache.end(); it++)
+	{
+		Chain * c = *it;
+
+		if(c->source == sourceMesh && c->version == version && c->stepSize == smoothStepSize 
+			&& c->numIteration == numIteration && c->isVolumePreserve == isVolumePreserve && c->regionFaces == regionFaces)
+		{
+			// Most recently used first
+			cache.erase(it);
+			cache.push_front(c);
+
+			c->users++;
+			return c;
+		}
+	}
+
+	Chain * c = new Chain;
+
+	c->source = sourceMesh;
+	c->version = version;
+	c->stepSize = smoothStepSize;
+	c->numIteration = numIteration;
+	c->isVolumePreserve = isVolumePreserve;
+	c->regionFaces = regionFaces;
+	c->users = 1;
+
+	cache.push_front(c);
+
+	return c;
+}
+
+void SmoothStairway::extendChain(Chain * chain, int numberSteps)
+{
+	if((int)chain->steps.size() >= numberSteps)
+		return;
+
+	// First step is special
+	if(chain->steps.empty())
+	{
+		// Optimization ?
+		chain->source->tempUmbrellas.reserve(chain->source->numberOfVertices());
+		chain->source->getUmbrellas();
+
+		chain->steps.push_back( SmoothStep(chain->source, chain->stepSize, chain->numIteration, 
+			chain->isVolumePreserve, &chain->flowState, chain->regionFaces) );
+	}
+
+	// Create steps, consecutive steps share the solver state
+	while((int)chain->steps.size() < numberSteps)
+	{
+		chain->steps.push_back( SmoothStep ( chain->steps.back().baseMesh(), chain->stepSize, chain->numIteration, 
+			chain->isVolumePreserve, &chain->flowState, chain->regionFaces) );
+	}
+}
+
+void SmoothStairway::trimCache()
+{
+	int unused = 0;
+
+	// Drop the least recently used chains nobody is holding
+	for(StdList<Chain *>::iterator it = cache.begin(); it != cache.end(); )
+	{
+		if((*it)->users < 1 && ++unused > MAX_CACHED_CHAINS)
+		{
+			delete *it;
+			it = cache.erase(it);
+		}
+		else
+			it++;
+	}
+}
+
+unsigned int SmoothStairway::meshVersion(Mesh * mesh)
+{
+	// FNV-1a over sizes and vertex positions
+	unsigned int hash = 2166136261u;
+
+	hash = (hash ^ (unsigned int)mesh->numberOfVertices()) * 16777619u;
+	hash = (hash ^ (unsigned int)mesh->numberOfFaces()) * 16777619u;
+
+	for(int i = 0; i < mesh->numberOfVertices(); i++)
+	{
+		Vertex * v = mesh->v(i);
+		float coord[3] = { (float)v->x, (float)v->y, (float)v->z };
+		unsigned int bits;
+
+		for(int c = 0; c < 3; c++)
+		{
+			memcpy(&bits, &coord[c], sizeof(bits));
+			hash = (hash ^ bits) * 16777619u;
+		}
+	}
+
+	return hash;
 }
 
 Mesh * SmoothStairway::mostDetailedMesh()
 {
 	// Top most detailed mesh
-	return step[0].detailedMesh();
+	return step[0]->detailedMesh();
 }
 
 Mesh * SmoothStairway::mostBaseMesh()
 {
 	// Last base mesh
-	return step.back().baseMesh();
+	return step.back()->baseMesh();
 }
 
 SmoothStep * SmoothStairway::mostBase()
 {
-	return &step[step.size()-1];
+	return step.back();
 }
 
 SmoothStep * SmoothStairway::getStep(int index)
 {
-	return &step[index];
+	return step[index];
 }
 
 Mesh * SmoothStairway::getStepBase(int index)
 {
-	return step[index].baseMesh();
+	return step[index]->baseMesh();
 }
 
 Mesh * SmoothStairway::getStepDetailed(int index)
 {
-	return step[index].detailedMesh();
+	return step[index]->detailedMesh();
 }
 
 int SmoothStairway::numberOfSteps()
@@ -88,7 +243,7 @@ void SmoothStairway::draw()
 
 	// Draw steps
 	for(int i = 0; i < numSteps; i++)
-		step[i].draw();
+		step[i]->draw();
 
 	// Draw displacement vectors
 	if(isDrawDisplacment)
@@ -5,14 +5,47 @@
 class SmoothStairway
 {
 private:
-	Vector<SmoothStep> step;
+	// Memoized chain of steps for one input, step k+1 smooths the base of step k.
+	// Chains are shared by every stairway with the same key and only grow.
+	struct Chain
+	{
+		Mesh * source;
+		unsigned int version;
+		float stepSize;
+		int numIteration;
+		bool isVolumePreserve;
+		Vector<int> regionFaces;
+
+		StdList<SmoothStep> steps;
+		Smoother::FlowState flowState;
+
+		int users;
+	};
+
+	static StdList<Chain *> cache;
+	static Chain * acquireChain(Mesh * sourceMesh, int numIteration, float smoothStepSize, bool isVolumePreserve,
+		const Vector<int> & regionFaces);
+	static void extendChain(Chain * chain, int numberSteps);
+	static void trimCache();
+
+	Chain * chain;
+	Vector<SmoothStep *> step;
 	Mesh * source;
 
 	int numSteps;
 
+	void release();
+
 public:
-	SmoothStairway(){ numSteps = 0; source = NULL; };
-	SmoothStairway(Mesh * sourceMesh, int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve);
+	SmoothStairway(){ numSteps = 0; source = NULL; chain = NULL; };
+	SmoothStairway(Mesh * sourceMesh, int numberSteps, int numIteration, float smoothStepSize, bool isVolumePreserve,
+		const Vector<int> & regionFaces = Vector<int>());
+	SmoothStairway(const SmoothStairway & from);
+	SmoothStairway & operator= (const SmoothStairway & from);
+	~SmoothStairway();
+
+	// Content signature, changes whenever the mesh geometry or size changes
+	static unsigned int meshVersion(Mesh * mesh);
 	
 	Mesh * mostBaseMesh();
 	Mesh * mostDetailedMesh();
@@ -2,7 +2,8 @@
 
 #include "SimpleDraw.h"
 
-SmoothStep::SmoothStep(Mesh * sourceMesh, float smoothStepSize, int numberIterations, bool isVolumePreserve)
+SmoothStep::SmoothStep(Mesh * sourceMesh, float smoothStepSize, int numberIterations, bool isVolumePreserve,
+					   Smoother::FlowState * flowState, const Vector<int> & regionFaces)
 {
 	this->detailed = sourceMesh;
 	this->smoothStep = smoothStepSize;
@@ -12,98 +13,191 @@ SmoothStep::SmoothStep(Mesh * sourceMesh, float smoothStepSize, int numberIterat
 	this->base = Mesh(*sourceMesh);
 	this->base.id = this->base.id + "_base";
 
-	// Perform smoothing
-	Smoother::MeanCurvatureFlow(&this->base, smoothStepSize, numIterations, isVolumePreserve);
+	// Perform smoothing, continuing from the previous step's solver state if any
+	Smoother::FlowState localState;
+	if(!flowState) flowState = &localState;
 
-	int numVertices = detailed->numberOfVertices();
+	if(regionFaces.empty())
+		Smoother::MeanCurvatureFlow(&this->base, smoothStepSize, numIterations, isVolumePreserve,
+			Smoother::SOLVER_AUTO, flowState);
+	else
+		smoothRegion(regionFaces, flowState);
 
-	// Compute displacement vectors
-	Vec rayOrigin, rayDirection;
+	this->solverIterations = flowState->iterations;
 
-	HitResult res;
-	Ray ray;
+	// In order to ignore borders
+	this->detailed->flagBorderVertices();
 
-	// Prepare mesh (hight change statistics)
-	/*Vector<float> distance(numVertices, NOT_SET);
-	base.clearAllFaceFlag();
+	// hide by default
+	this->isVisible = false;
+}
 
-	for(int i = 0; i < numVertices; i++)
+void SmoothStep::smoothRegion(const Vector<int> & regionFaces, Smoother::FlowState * flowState)
+{
+	// Grow region by a margin so the fixed border is away from the faces we care about
+	StdSet<int> regionPoints = base.getVerticesFromFaces(regionFaces);
+	StdSet<Face*> faces;
+
+	for(int k = 0; k < REGION_MARGIN_RINGS; k++)
 	{
-		ray.origin = detailed->v(i)->vec();
-		ray.direction = -base.n(i)->vec();
+		faces = base.getFacesFromVertices(regionPoints);
 
-		VertexDetail * vd = base.vd(i);
+		for(StdSet<Face*>::iterator f = faces.begin(); f != faces.end(); f++)
+			for(int j = 0; j < 3; j++)
+				regionPoints.insert((*f)->VIndex(j));
+	}
 
-		// using Breadth-first search (for some depth)
-		distance[i] = IntersectionSearch(&base, vd, ray, res, vd->index);
+	Vector<int> faceIndices;
+	for(StdSet<Face*>::iterator f = faces.begin(); f != faces.end(); f++)
+		faceIndices.push_back((*f)->index);
 
-		if(distance[i] == NOT_SET)
-			distance[i] = 0;
-	}*/
+	// Fixed order regardless of pointer values
+	std::sort(faceIndices.begin(), faceIndices.end());
 
-	// Create vectors
-	height = Vector<Vec>(numVertices);
-	shift = Vector<Vec>(numVertices);
+	Vector<int> oldIndex;
+	Mesh * region = base.CloneSubMesh(faceIndices, true, base.id + "_region", &oldIndex);
 
-	// In order to ignore borders
-	this->detailed->flagBorderVertices();
+	printf("\nSmoothing region of %d / %d vertices", region->numberOfVertices(), base.numberOfVertices());
 
-	/*for(int i = 0; i < numVertices; i++)
+	// Border of the region is held fixed, scaling for volume would move it
+	Smoother::MeanCurvatureFlow(region, smoothStep, numIterations, false,
+		Smoother::SOLVER_AUTO, flowState, true);
+
+	for(int i = 0; i < (int)oldIndex.size(); i++)
+		base.v(oldIndex[i])->set(*region->v(i));
+
+	delete region;
+
+	base.computeNormals();
+	base.computeBounds();
+
+	base.setDirtyVBO(true);
+}
+
+// Closest hit, in either direction, of a ray among a set of triangles
+static BaseTriangle * closestHit(const Ray & ray, BaseTriangle ** tris, int count, double & distance)
+{
+	BaseTriangle * closest = NULL;
+	HitResult res;
+
+	for(int t = 0; t < count; t++)
 	{
-		if(this->detailed->vd(i)->flag != VF_BORDER)
+		tris[t]->intersectionTest(ray, res, true);
+
+		if(res.hit && (!closest || abs(res.distance) < abs(distance)))
 		{
-			height[i] = (base.n(i)->vec() * -distance[i]);
-			shift[i] = (detailed->v(i)->vec() + height[i]) - base.v(i)->vec();
+			closest = tris[t];
+			distance = res.distance;
 		}
-	}*/
+	}
 
-	// hide by default
-	this->isVisible = false;
+	return closest;
 }
 
-float SmoothStep::IntersectionSearch(Mesh * mesh, VertexDetail * vd, Ray & ray, HitResult & res, int flag, int depth)
+void SmoothStep::computeDisplacements()
 {
-	if(depth > 2 || vd->isBorderFlag())
-		return NOT_SET;
+	CreateTimer(timer);
+
+	int numVertices = detailed->numberOfVertices();
 
-	float distance = NOT_SET;
+	height = Vector<float>(numVertices, 0);
+	shift = Vector<Vec>(numVertices);
 
-	for(Vector<Face*>::iterator faces = vd->ifaces.begin(); faces != vd->ifaces.end(); faces++)
+	Vector<int> misses;
+
+	// Local first: the base hit is almost always in the two ring of the same vertex
+	#pragma omp parallel
 	{
-		Face * f = *faces;
+		Vector<BaseTriangle*> ring;
+		Vector<int> localMisses;
 
-		if(f->flag != flag)
+		#pragma omp for
+		for(int i = 0; i < numVertices; i++)
 		{
-			f->intersectionTest(ray, res);
+			if(detailed->vd(i)->flag == VF_BORDER)
+				continue;
+
+			Vec normal = *base.n(i);
+			Ray ray(*detailed->v(i), -normal);
 
-			if(res.hit && res.distance < distance)
+			ring.clear();
+
+			Vector<Face*> * ifaces = &base.vd(i)->ifaces;
+			for(int f = 0; f < (int)ifaces->size(); f++)
+				for(int j = 0; j < 3; j++)
+				{
+					Vector<Face*> * jfaces = &base.vd(ifaces->at(f)->VIndex(j))->ifaces;
+					ring.insert(ring.end(), jfaces->begin(), jfaces->end());
+				}
+
+			double distance = 0;
+
+			if(ring.size() && closestHit(ray, &ring[0], ring.size(), distance))
 			{
-				distance = res.distance;
-				break;
+				height[i] = distance;
+				shift[i] = (*detailed->v(i) - normal * distance) - *base.v(i);
 			}
-
-			// mark as visited face
-			f->flag = flag;
+			else
+				localMisses.push_back(i);
 		}
+
+		#pragma omp critical
+		misses.insert(misses.end(), localMisses.begin(), localMisses.end());
 	}
 
-	if(distance == NOT_SET)
+	// Global fallback through an octree of the whole base
+	if(misses.size())
 	{
-		for(Vector<Face*>::iterator faces = vd->ifaces.begin(); faces != vd->ifaces.end(); faces++)
+		StdList<BaseTriangle*> baseFaces = base.facesListPointers();
+		Octree tree(baseFaces, 20);
+
+		int maxIndex = 0;
+		for(StdList<BaseTriangle*>::iterator f = baseFaces.begin(); f != baseFaces.end(); f++)
+			maxIndex = Max(maxIndex, (*f)->index);
+
+		Vector<BaseTriangle*> faceByIndex(maxIndex + 1, (BaseTriangle*)NULL);
+		for(StdList<BaseTriangle*>::iterator f = baseFaces.begin(); f != baseFaces.end(); f++)
+			faceByIndex[(*f)->index] = *f;
+
+		#pragma omp parallel
 		{
-			Face * f = *faces;
+			Vector<BaseTriangle*> candidates;
 
-			for(int i = 0; i < 3; i++)
+			#pragma omp for
+			for(int m = 0; m < (int)misses.size(); m++)
 			{
-				distance = IntersectionSearch(mesh, mesh->vd(f->VIndex(i)), ray, res, flag, ++depth);
-				
-				if(distance != NOT_SET)
-					break;
+				int i = misses[m];
+
+				Vec normal = *base.n(i);
+				Vec diff = *detailed->v(i) - *base.v(i);
+
+				Ray ray(*detailed->v(i), -normal);
+
+				IndexSet tris;
+				tree.intersectRayBoth(ray, tris);
+
+				candidates.clear();
+				for(IndexSetIter it = tris.begin(); it != tris.end(); it++)
+					candidates.push_back(faceByIndex[*it]);
+
+				double distance = 0;
+
+				if(candidates.size() && closestHit(ray, &candidates[0], candidates.size(), distance))
+				{
+					height[i] = distance;
+					shift[i] = (*detailed->v(i) - normal * distance) - *base.v(i);
+				}
+				else
+				{
+					// Nothing hit, split the plain difference
+					height[i] = diff * normal;
+					shift[i] = diff - normal * height[i];
+				}
 			}
 		}
 	}
 
-	return distance;
+	printf("\nDisplacements: %d vertices, %d global searches (%d ms)", numVertices, (int)misses.size(), (int)timer.elapsed());
 }
 
 Mesh * SmoothStep::detailedMesh()
@@ -116,19 +210,28 @@ Mesh * SmoothStep::baseMesh()
 	return &this->base;
 }
 
+int SmoothStep::numberOfSolverIterations()
+{
+	return this->solverIterations;
+}
+
 void SmoothStep::draw()
 {
 	if(this->isVisible)
 	{
 		int numVertices = detailed->numberOfVertices();
 
+		// Only drawn, so only cast once someone looks
+		if((int)height.size() != numVertices)
+			computeDisplacements();
+
 		Vector<Vec> height_starts, height_ends;
 		Vector<Vec> shift_starts, shift_ends;
 
 		for(int i = 0; i < numVertices; i++)
 		{
 			height_starts.push_back(detailed->v(i)->vec());
-			height_ends.push_back(detailed->v(i)->vec() + height[i]);
+			height_ends.push_back(detailed->v(i)->vec() - (*base.n(i) * height[i]));
 
 			shift_starts.push_back(base.v(i)->vec());
 			shift_ends.push_back(base.v(i)->vec() + shift[i]);
@@ -5,6 +5,9 @@
 
 #define NOT_SET FLT_MAX
 
+// Rings around a smoothing region that are solved but not used, the outer one is held fixed
+#define REGION_MARGIN_RINGS 3
+
 class SmoothStep
 {
 private:
@@ -13,19 +16,26 @@ private:
 
 	float smoothStep;
 	int numIterations;
+	int solverIterations;
 
-	Vector<Vec> height;
+	// Signed height along the base normal and tangential shift of the foot point,
+	// per vertex of the detailed mesh. Computed on the first draw
+	Vector<float> height;
 	Vector<Vec> shift;
 
 	bool isVisible;
 
+	void smoothRegion(const Vector<int> & regionFaces, Smoother::FlowState * flowState);
+	void computeDisplacements();
+
 public:
-	SmoothStep(Mesh * sourceMesh, float smoothStepSize, int numberIterations, bool isVolumePreserve);
+	SmoothStep(Mesh * sourceMesh, float smoothStepSize, int numberIterations, bool isVolumePreserve,
+		Smoother::FlowState * flowState = NULL, const Vector<int> & regionFaces = Vector<int>());
 	
 	Mesh * detailedMesh();
 	Mesh * baseMesh();
 
-	float IntersectionSearch(Mesh * mesh, VertexDetail * vd, Ray & ray, HitResult & res, int flag, int depth = 0);
+	int numberOfSolverIterations();
 
 	// VISUALIZATION
 	void draw();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Vertex.h"
+#include "GridPoint.h"
+
+// A grid square ready for placing its points: corners, normal and the
+// direction shift angles are measured from. The shift is turned about the
+// normal with Rodrigues' formula, no quaternion is built per point.
+struct SquareFrame
+{
+	Vec q[4];
+
+	Vec normal;		// unit
+	Vec ref;		// angle zero
+	Vec side;		// normal x ref
+	double refNormal;	// ref . normal, zero when ref lies on the square
+
+	SquareFrame(){ refNormal = 0; }
+
+	SquareFrame(const Vec & q0, const Vec & q1, const Vec & q2, const Vec & q3, const Vec & squareNormal, const Vec & refDirection)
+	{
+		q[0] = q0;
+		q[1] = q1;
+		q[2] = q2;
+		q[3] = q3;
+
+		normal = squareNormal;
+		ref = refDirection;
+		side = normal ^ ref;
+		refNormal = normal * ref;
+	}
+
+	inline Vec pointOnSquare(const float w[]) const
+	{
+		return Vec(q[0].x * w[0] + q[1].x * w[1] + q[2].x * w[2] + q[3].x * w[3],
+			q[0].y * w[0] + q[1].y * w[1] + q[2].y * w[2] + q[3].y * w[3],
+			q[0].z * w[0] + q[1].z * w[1] + q[2].z * w[2] + q[3].z * w[3]);
+	}
+
+	inline Vec reconstruct(const float w[], double height, double angle, double shift) const
+	{
+		double c = cos(angle), s = sin(angle);
+
+		Vec rotatedRef = (ref * c) + (side * s) + (normal * (refNormal * (1.0 - c)));
+
+		return pointOnSquare(w) + (normal * height) + (rotatedRef * shift);
+	}
+
+	// Reconstructs 'count' points into separate coordinate arrays
+	void reconstruct(const GridPoint * points, int count, double x[], double y[], double z[]) const
+	{
+		for(int i = 0; i < count; i++)
+		{
+			const GridPoint & p = points[i];
+
+			double c = cos(p.shiftAngle), s = sin(p.shiftAngle);
+
+			double a = p.shiftMagnitude * c;
+			double b = p.shiftMagnitude * s;
+			double n = p.h + p.shiftMagnitude * refNormal * (1.0 - c);
+
+			x[i] = q[0].x * p.w[0] + q[1].x * p.w[1] + q[2].x * p.w[2] + q[3].x * p.w[3] + n * normal.x + a * ref.x + b * side.x;
+			y[i] = q[0].y * p.w[0] + q[1].y * p.w[1] + q[2].y * p.w[2] + q[3].y * p.w[3] + n * normal.y + a * ref.y + b * side.y;
+			z[i] = q[0].z * p.w[0] + q[1].z * p.w[1] + q[2].z * p.w[2] + q[3].z * p.w[3] + n * normal.z + a * ref.z + b * side.z;
+		}
+	}
+};
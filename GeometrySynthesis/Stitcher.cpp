@@ -7,7 +7,7 @@
 
 double theta = M_PI / 18.0; // 10 deg
 
-Stitcher::Stitcher(GridMesh * srcGridMesh, bool isFillSeams)
+Stitcher::Stitcher(GridMesh * srcGridMesh, bool isFillSeams, bool isForDrawing)
 {
 	this->gm = srcGridMesh;
 	tri_patch = &gm->tri_patch;
@@ -51,7 +51,7 @@ Stitcher::Stitcher(GridMesh * srcGridMesh, bool isFillSeams)
 
 	// Refresh mesh 'M' for drawing
 	M->computeNormals();
-	M->rebuildVBO();
+	if(isForDrawing) M->rebuildVBO();
 	
 	M->isReady = true;
 	M->isVisible = true;
@@ -23,7 +23,8 @@ private:
 	void fillSmallHole(Mesh * M, int borderVertex);
 
 public:
-	Stitcher(GridMesh * srcGridMesh, bool isFillSeams);
+	// 'isForDrawing' builds the GPU buffer of the stitched mesh
+	Stitcher(GridMesh * srcGridMesh, bool isFillSeams, bool isForDrawing = true);
 
 	//void FindSeams();
 
@@ -2,6 +2,8 @@
 #include "SimpleDraw.h"
 #include "Transform.h"
 
+#include <omp.h>
+
 LocalFrame::LocalFrame()
 {
 }
@@ -45,41 +47,109 @@ void LocalFrame::draw(const Vec& center)
 
 Vector<LocalFrame> LocalFrame::alongTangent( const Vector<Vec>& tangent )
 {
-        Vector<LocalFrame> result;
+	return alongTangent(tangent, tangent.front().orthogonalVec());
+}
+
+Vector<LocalFrame> LocalFrame::alongTangent( const Vector<Vec>& tangent, const Vec& firstUp )
+{
+	Vector<Rotation> turn;
+
+	return alongTangent(tangent, firstUp, turn);
+}
+
+Vector<LocalFrame> LocalFrame::alongTangent( const Vector<Vec>& tangent, const Vec& firstUp, Vector<Rotation>& turn )
+{
+	int N = tangent.size();
+
+	turn = minimalRotations(tangent);
 
-	// First frame
-        result.push_back(LocalFrame (tangent.front(), tangent.front().orthogonalVec()));
+	// First frame, the others are it turned
+	LocalFrame first(tangent.front(), firstUp);
 
-	// Remaining
-        for(unsigned int i = 1; i < tangent.size(); i++)
+	Vector<LocalFrame> result(N);
+
+	#pragma omp parallel for
+	for(int i = 0; i < N; i++)
 	{
-            Vec newNormal = tangent[i];
-            LocalFrame frame;
-            LocalFrame prev = result.back();
+		result[i].n = tangent[i];
+		result[i].up = turn[i].rotate(first.up);
+		result[i].b = turn[i].rotate(first.b);
+	}
+
+	return result;
+}
+
+Vector<Rotation> LocalFrame::minimalRotations( const Vector<Vec>& tangent )
+{
+	int N = tangent.size();
 
-            Rotation q(prev.n, newNormal);
+	Vector<Rotation> turn(N);
 
-            frame.n = newNormal;
-            frame.up = q.rotate(prev.up);
-            frame.b = q.rotate(prev.b);
+	if(N < 2) return turn;
 
-            result.push_back(frame);
-        }
+	// Steps between consecutive tangents
+	#pragma omp parallel for
+	for(int i = 1; i < N; i++)
+		turn[i] = Rotation(tangent[i-1], tangent[i]);
 
-        return result;
+	// Compose within blocks, then carry each block's total to the next
+	int blockSize = (N + omp_get_max_threads() - 1) / omp_get_max_threads();
+	int numBlocks = (N + blockSize - 1) / blockSize;
+
+	#pragma omp parallel for
+	for(int k = 0; k < numBlocks; k++)
+	{
+		int end = Min(N, (k + 1) * blockSize);
+
+		for(int i = k * blockSize + 1; i < end; i++)
+			turn[i] = turn[i] * turn[i-1];
+	}
+
+	Vector<Rotation> carry(numBlocks);
+
+	for(int k = 1; k < numBlocks; k++)
+		carry[k] = turn[k * blockSize - 1] * carry[k-1];
+
+	#pragma omp parallel for
+	for(int k = 1; k < numBlocks; k++)
+	{
+		int end = Min(N, (k + 1) * blockSize);
+
+		for(int i = k * blockSize; i < end; i++)
+		{
+			turn[i] = turn[i] * carry[k];
+			turn[i].normalize();
+		}
+	}
+
+	return turn;
 }
 
-Vector<LocalFrame> LocalFrame::alongTangent( const Vector<Vec>& tangent, const Vec& firstUp )
+void LocalFrame::smoothTangent( Vector<Vec>& tangent, int numIterations )
 {
-        Vector<LocalFrame> result;
+	int N = tangent.size();
 
-	// First frame
-	result.push_back(LocalFrame(tangent.front(), firstUp));
+	if(N < 7) return;
 
-        for(int i = 1; i < (int)tangent.size(); i++)
-		result.push_back( LocalFrame(result.back(), tangent[i]) );
+	for(int it = 0; it < numIterations; it++)
+	{
+		// Running sum of the neighbors, tangents already smoothed
+		// behind 'i' are kept in their old values
+		Vec behind[3] = {tangent[0], tangent[1], tangent[2]};
+		Vec sum = tangent[0] + tangent[1] + tangent[2] + tangent[4] + tangent[5] + tangent[6];
 
-	return result;
+		for(int i = 3; i < N - 3; i++)
+		{
+			Vec old = tangent[i];
+
+			tangent[i] = (sum / 6.0f).unit();
+
+			if(i + 4 < N)
+				sum += old - behind[i % 3] - tangent[i+1] + tangent[i+4];
+
+			behind[i % 3] = old;
+		}
+	}
 }
 
 Rotation LocalFrame::rotation( const LocalFrame& A, const LocalFrame& B )
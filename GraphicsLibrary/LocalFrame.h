@@ -18,6 +18,14 @@ public:
 
         static Vector<LocalFrame> alongTangent( const Vector<Vec>& tangent );
         static Vector<LocalFrame> alongTangent( const Vector<Vec>& tangent, const Vec& firstUp );
+        static Vector<LocalFrame> alongTangent( const Vector<Vec>& tangent, const Vec& firstUp, Vector<Rotation>& turn );
+
+        // Minimal rotation from the first tangent to each tangent, composed
+        // step by step as a parallel prefix scan
+        static Vector<Rotation> minimalRotations( const Vector<Vec>& tangent );
+
+        // Average of the three tangents on each side, in place
+        static void smoothTangent( Vector<Vec>& tangent, int numIterations = 4 );
 
         void draw(const Vec& center);
 
@@ -169,6 +169,8 @@ Mesh& Mesh::operator= (const Mesh& fromMesh)
 			this->faceIndexMap[f->index] = &(*f);
 		}
 
+		if(this->vbo)	delete vbo;
+
 		if(fromMesh.vbo == NULL)
 			this->vbo = NULL;
 		else
@@ -839,6 +841,8 @@ void Mesh::setDirtyVBO(bool state)
 
 void Mesh::rebuildVBO()
 {
+	if(vbo)	delete vbo;
+
 	vbo = new VBO(&this->vertex, &this->vNormal, &this->vColor, &this->face);
 
 	this->isReady = true;
@@ -1147,7 +1151,7 @@ void Mesh::drawFaceNames()
 	}
 }
 
-Mesh * Mesh::CloneSubMesh ( Vector<int> & facesIndex, bool isShallowClone, StdString newId)
+Mesh * Mesh::CloneSubMesh ( Vector<int> & facesIndex, bool isShallowClone, StdString newId, Vector<int> * oldIndex)
 {
 	int numFaces = facesIndex.size();
 	int numVertices = numFaces * 3;
@@ -1205,6 +1209,15 @@ Mesh * Mesh::CloneSubMesh ( Vector<int> & facesIndex, bool isShallowClone, StdSt
 		clone->addFace(v1, v2, v3, fCount++);
 	}
 
+	// oldIndex[ new index ] = old vertex index
+	if(oldIndex)
+	{
+		oldIndex->resize(vCount);
+
+		for(StdMap<int,int>::iterator it = vIndexMap.begin(); it != vIndexMap.end(); it++)
+			(*oldIndex)[it->second] = it->first;
+	}
+
 	if(!isShallowClone)
 	{
 		clone->clearColors();
@@ -227,7 +227,7 @@ public:
 	StdString fileName;
 
 	// SUB MESH
-	Mesh * CloneSubMesh(Vector<int> & facesIndex, bool isShallowClone = false, StdString newId = "");
+	Mesh * CloneSubMesh(Vector<int> & facesIndex, bool isShallowClone = false, StdString newId = "", Vector<int> * oldIndex = NULL);
 
 	// My friends
 	friend class Smoother;
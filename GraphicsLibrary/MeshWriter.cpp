@@ -0,0 +1,54 @@
+#include "MeshWriter.h"
+
+MeshWriter::MeshWriter(const char* fileName)
+{
+	fp = fopen(fileName, "w");
+
+	vertexCount = 0;
+	faceCount = 0;
+}
+
+MeshWriter::~MeshWriter()
+{
+	close();
+}
+
+bool MeshWriter::isOpen()
+{
+	return fp != NULL;
+}
+
+int MeshWriter::addVertex(const Vec & v)
+{
+	if(fp) fprintf(fp, "v %f %f %f\n", v.x, v.y, v.z);
+
+	return vertexCount++;
+}
+
+void MeshWriter::addFace(int v1, int v2, int v3)
+{
+	if(fp) fprintf(fp, "f %d %d %d\n", v1 + 1, v2 + 1, v3 + 1);
+
+	faceCount++;
+}
+
+int MeshWriter::numberOfVertices()
+{
+	return vertexCount;
+}
+
+int MeshWriter::numberOfFaces()
+{
+	return faceCount;
+}
+
+void MeshWriter::close()
+{
+	if(fp == NULL) return;
+
+	// Counts are only known at the end
+	fprintf(fp, "# Vertices %d, Faces %d\n", vertexCount, faceCount);
+
+	fclose(fp);
+	fp = NULL;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "Vertex.h"
+
+// Writes an .OBJ file as vertices and faces come in, nothing is kept
+class MeshWriter
+{
+private:
+	FILE * fp;
+
+	int vertexCount;
+	int faceCount;
+
+public:
+	MeshWriter(const char* fileName);
+	~MeshWriter();
+
+	bool isOpen();
+
+	// Index of the written vertex, starting at zero
+	int addVertex(const Vec & v);
+	void addFace(int v1, int v2, int v3);
+
+	int numberOfVertices();
+	int numberOfFaces();
+
+	void close();
+};
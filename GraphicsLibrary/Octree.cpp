@@ -306,6 +306,34 @@ void Octree::intersectRayBoth( const Ray& ray, IndexSet & tris )
 }
 
 BaseTriangle* Octree::findClosestTri( const Ray & ray, IndexSet & tris, Mesh * mesh, HitResult & hitRes )
+{
+	// Find the triangles in this tree
+	intersectRayBoth(ray, tris);
+
+	Vector<BaseTriangle*> candidates;
+
+	for(IndexSetIter it = tris.begin(); it != tris.end(); it++)
+		candidates.push_back(mesh->f(*it));
+
+	return closestTri(ray, candidates, hitRes);
+}
+
+BaseTriangle* Octree::findClosestTri( const Ray & ray, IndexSet & tris, const Vector<BaseTriangle*> & faces, HitResult & hitRes )
+{
+	intersectRayBoth(ray, tris);
+
+	Vector<BaseTriangle*> candidates;
+
+	for(IndexSetIter it = tris.begin(); it != tris.end(); it++)
+	{
+		if(*it >= 0 && *it < (int)faces.size() && faces[*it])
+			candidates.push_back(faces[*it]);
+	}
+
+	return closestTri(ray, candidates, hitRes);
+}
+
+BaseTriangle* Octree::closestTri( const Ray & ray, const Vector<BaseTriangle*> & candidates, HitResult & hitRes )
 {
 	double minDist = DBL_MAX;
 	BaseTriangle *closestFace = NULL, *curr_FaceType = NULL;
@@ -313,12 +341,9 @@ BaseTriangle* Octree::findClosestTri( const Ray & ray, IndexSet & tris, Mesh * m
 	double u = 0.0, v = 0.0;
 	double actualMinDist = 0;
 
-	// Find the triangles in this tree
-	intersectRayBoth(ray, tris);
-
-	for(IndexSetIter it = tris.begin(); it != tris.end(); it++)
+	for(int i = 0; i < (int)candidates.size(); i++)
 	{
-		curr_FaceType = mesh->f(*it);
+		curr_FaceType = candidates[i];
 
 		curr_FaceType->intersectionTest(ray, hitRes, true);
 
@@ -24,6 +24,8 @@ private:
 	Vector<Octree> children;
 	Vector<BaseTriangle*> triangleData;
 
+	BaseTriangle* closestTri(const Ray & ray, const Vector<BaseTriangle*> & candidates, HitResult & hitRes);
+
 public:
 	BoundingBox boundingBox;
 	int trianglePerNode;
@@ -57,6 +59,9 @@ public:
 
 	BaseTriangle* findClosestTri(const Ray & ray, IndexSet & tris, Mesh * mesh, HitResult & hitRes);
 
+	// Faces looked up in a table by index, missing ones skipped. Safe from several threads
+	BaseTriangle* findClosestTri(const Ray & ray, IndexSet & tris, const Vector<BaseTriangle*> & faces, HitResult & hitRes);
+
 	/* Perform intersection tests  */
 	bool testIntersectHit(const Ray& ray, HitResult & hitRes);
 	void testIntersectRayBoth(const Ray& ray, HitResult & hitRes);
@@ -236,7 +236,7 @@ void Smoother::ScaleDependentSmoothing(Mesh * m, int numIteration, float step_si
 * K_{ij} = -sum_j cot_{ij} for i = j
 *
 */
-void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool isVolumePreservation)
+void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool isVolumePreservation, LinearSolver solver, FlowState * state, bool isFixedBorder)
 {
 	if(step == 0.0)	return;
 
@@ -255,16 +255,39 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 
 	U = &mesh->tempUmbrellas;
 
-	// Process borders, from paper's suggestion of virtual center point
-	treatBorders(mesh, *U);
+	// Process borders, from paper's suggestion of virtual center point,
+	// unless they are fixed (Dirichlet) in which case they stay as they are
+	if(!isFixedBorder)
+		treatBorders(mesh, *U);
 
 	int N = U->size();
 
+	// Diagonal preconditioning stalls on large meshes, switch to multigrid
+	if(solver == SOLVER_AUTO)
+		solver = (N > 5000) ? SOLVER_MULTIGRID_CG : SOLVER_BICG;
+
+	// Without an outside state, still carry it across our own iterations
+	FlowState localState;
+	if(!state) state = &localState;
+
+	// Carried state only applies to the same unknowns
+	if((int)state->delta.size() != N)
+	{
+		state->delta.clear();
+		state->displacement = 0;
+
+		delete state->precond;
+		state->precond = NULL;
+	}
+
+	state->iterations = 0;
+
 	// Initialize B & X vectors
 
 	VECTOR_double b_x(N), b_y(N), b_z(N);
 	VECTOR_double X(N), Y(N), Z(N);
 	Vector<double> area (N, 0.0);
+	Vector<Vec> start (N);
 
 	double dt = step;
 	double alpha, beta, cots;
@@ -290,6 +313,9 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 
 			M.coeffRef(i,i) = area[i];
 
+			// Pull of fixed border neighbours, known so it goes to the right hand side
+			Vec fixedPull(0,0,0);
+
 			if((U->at(i)).flag != VF_BORDER)
 			{
 				for(HalfEdgeSet::iterator halfEdge = (U->at(i)).halfEdge.begin(); halfEdge != (U->at(i)).halfEdge.end(); halfEdge++)
@@ -309,11 +335,15 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 
 						cots = (alpha + beta) * 0.25 * dt;
 
-						if(alpha == 0 || beta == 0 || (U->at(j)).flag == VF_BORDER)
+						if(alpha == 0 || beta == 0 || ((U->at(j)).flag == VF_BORDER && !isFixedBorder))
 							cots = 0;
 					}
 
-					if(i > j)
+					if(isFixedBorder && (U->at(j)).flag == VF_BORDER)
+					{
+						fixedPull += mesh->v(j)->vec() * cots;
+					}
+					else if(i > j)
 					{
 						M.coeffRef(i,j) -= cots;
 						M.coeffRef(j,i) -= cots;
@@ -334,9 +364,22 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 			Y(i) = vertex->y;
 			Z(i) = vertex->z;
 
-			b_x(i) = area[i] * X(i);
-			b_y(i) = area[i] * Y(i);
-			b_z(i) = area[i] * Z(i);
+			b_x(i) = area[i] * X(i) + fixedPull.x;
+			b_y(i) = area[i] * Y(i) + fixedPull.y;
+			b_z(i) = area[i] * Z(i) + fixedPull.z;
+
+			start[i] = Vec(X(i), Y(i), Z(i));
+		}
+
+		// Warm start, the previous update predicts this one
+		if(!state->delta.empty())
+		{
+			for(int i = 0; i < N; i++)
+			{
+				X(i) += state->delta[i].x;
+				Y(i) += state->delta[i].y;
+				Z(i) += state->delta[i].z;
+			}
 		}
 
 		Eigen::SparseMatrix<double> mat(M);
@@ -345,40 +388,111 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 		//Eigen::IOFormat CleanFmt(4, 0, ", ", "\n", "[", "]");
 		//std::cout << "\n" << mat.toDense().format(CleanFmt) << "\n";
 
-		// Solver tolerance
+		// Solver tolerance, tightened so the solve error stays well below
+		// the displacement the previous update produced
 		double tol = 0.01;
+
+		if(state->displacement > 0)
+		{
+			double positionRms = 0;
+			for(int i = 0; i < N; i++)
+				positionRms += start[i].squaredNorm();
+			positionRms = sqrt(positionRms / N);
+
+			if(positionRms > 0)
+				tol = Max(1e-6, Min(0.01, 0.05 * state->displacement / positionRms));
+		}
+
 		double tol_x = tol, tol_y = tol, tol_z = tol;
 		int maxit = 500, maxit_x = maxit, maxit_y = maxit, maxit_z = maxit;
 		int result;
 
-		// Precondition
-		DiagPreconditioner_double precond(A);
-
 		CreateTimer(solveTime);
 		printf("\nSolving..");
 
-		// Solve
-		//		#pragma omp parallel sections
+		if(solver == SOLVER_BICG)
+		{
+			// Precondition
+			DiagPreconditioner_double precond(A);
+
+			// Solve
+			//		#pragma omp parallel sections
+			{
+				//			#pragma omp section
+				{
+					result = Solver::BiCG(A, X, b_x, precond, maxit_x, tol_x);
+					printf(" conv X = %s ..",(result)?"false":"true");
+				}
+
+				//			#pragma omp section
+				{
+					result = Solver::BiCG(A, Y, b_y, precond, maxit_y, tol_y);
+					printf(" conv Y = %s ..",(result)?"false":"true");
+				}
+
+				//			#pragma omp section
+				{
+					result = Solver::BiCG(A, Z, b_z, precond, maxit_z, tol_z);
+					printf(" conv Z = %s ..",(result)?"false":"true");
+				}
+			}
+		}
+		else
 		{
-			//			#pragma omp section
+			// Hierarchy is shared by the three coordinate solves and reused by later
+			// solves on the same connectivity, the systems barely change between them
+			bool isBuilt = (state->precond == NULL);
+
+			if(isBuilt)
 			{
-				result = Solver::BiCG(A, X, b_x, precond, maxit_x, tol_x);
-				printf(" conv X = %s ..",(result)?"false":"true");
+				state->precond = new MultigridPreconditioner_double(A);
+				printf(" multigrid levels = %d (complexity %.2f) ..", state->precond->numLevels(), state->precond->operatorComplexity());
 			}
 
-			//			#pragma omp section
+			MultigridPreconditioner_double & precond = *state->precond;
+
+			if(solver == SOLVER_MULTIGRID_CG)
 			{
-				result = Solver::BiCG(A, Y, b_y, precond, maxit_y, tol_y);
-				printf(" conv Y = %s ..",(result)?"false":"true");
+				result = Solver::CG(A, X, b_x, precond, maxit_x, tol_x);
+				result |= Solver::CG(A, Y, b_y, precond, maxit_y, tol_y);
+				result |= Solver::CG(A, Z, b_z, precond, maxit_z, tol_z);
 			}
+			else
+			{
+				result = Solver::IR(A, X, b_x, precond, maxit_x, tol_x);
+				result |= Solver::IR(A, Y, b_y, precond, maxit_y, tol_y);
+				result |= Solver::IR(A, Z, b_z, precond, maxit_z, tol_z);
+			}
+
+			printf(" conv = %s ..", (result)?"false":"true");
 
-			//			#pragma omp section
+			// Rebuild next time once the reused hierarchy has gone stale
+			int worst = Max(maxit_x, Max(maxit_y, maxit_z));
+
+			if(isBuilt)
+				state->precondIterations = worst;
+			else if(worst > 2 * state->precondIterations + 5)
 			{
-				result = Solver::BiCG(A, Z, b_z, precond, maxit_z, tol_z);
-				printf(" conv Z = %s ..",(result)?"false":"true");
+				delete state->precond;
+				state->precond = NULL;
 			}
 		}
 
+		state->iterations += maxit_x + maxit_y + maxit_z;
+		printf(" iterations = %d / %d / %d (tol = %g) ..", maxit_x, maxit_y, maxit_z, tol);
+
+		// Remember this update for the next solve
+		state->delta.resize(N);
+		state->displacement = 0;
+
+		for(int i = 0; i < N; i++)
+		{
+			state->delta[i] = Vec(X(i), Y(i), Z(i)) - start[i];
+			state->displacement += state->delta[i].squaredNorm();
+		}
+
+		state->displacement = sqrt(state->displacement / N);
+
 		printf("\nSolve time = %d ms\n", (int)solveTime.elapsed());
 
 		Vec center = mesh->computeCenter();
@@ -402,7 +516,8 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 		mesh->translate(center);
 
 		// Undo addition of virtual hole center points
-		untreatBorders(mesh, *U);
+		if(!isFixedBorder)
+			untreatBorders(mesh, *U);
 
 	}
 
@@ -411,7 +526,7 @@ void Smoother::MeanCurvatureFlow(Mesh * mesh, double step,int numIteration, bool
 	mesh->computeNormals();
 	mesh->computeBounds();
 
-	mesh->vbo->setDirty(true);
+	if(mesh->vbo) mesh->vbo->setDirty(true);
 }
 
 void Smoother::MeanCurvatureFlowExplicit(Mesh * mesh, double step, int numIteration)
@@ -16,12 +16,14 @@
 #include "diagpre_double.h"
 #include "icpre_double.h"
 #include "ilupre_double.h"
+#include "mgpre_double.h"
 
 // Solvers
 #include "bicg.h"
 #include "bicgstab.h"
 #include "cg.h"
 #include "cgs.h"
+#include "ir.h"
 
 #define Vector std::vector
 // End of Solver ================
@@ -36,6 +38,30 @@
 using namespace Eigen;
 
 class Smoother{
+public:
+	// Linear solver for the implicit flow, AUTO picks multigrid for large meshes
+	enum LinearSolver{ SOLVER_AUTO, SOLVER_BICG, SOLVER_MULTIGRID_CG, SOLVER_MULTIGRID };
+
+	// Solver state carried between consecutive flows on the same connectivity,
+	// e.g. the steps of a SmoothStairway
+	struct FlowState
+	{
+		MultigridPreconditioner_double * precond;
+		int precondIterations;		// iterations needed right after the hierarchy was built
+
+		Vector<Vec> delta;			// last update per unknown, predicts the next one
+		double displacement;		// RMS of the last update
+
+		int iterations;				// total solver iterations of the last flow
+
+		FlowState() : precond(NULL), precondIterations(0), displacement(0), iterations(0) {}
+		~FlowState() { delete precond; }
+
+	private:
+		FlowState(const FlowState &);
+		FlowState & operator= (const FlowState &);
+	};
+
 private:
 	static void treatBorders(Mesh * mesh, Vector<Umbrella> & U);
 	static void untreatBorders(Mesh * mesh, Vector<Umbrella> & U);
@@ -48,7 +74,8 @@ public:
 	static void ScaleDependentSmoothing(Mesh * m, int numIteration, float step_size = 0.5f, bool protectBorders = true);
 	static Vertex ScaleDependentSmoothVertex(Mesh * m, int vi, float step_size = 0.5f);
 
-	static void MeanCurvatureFlow(Mesh * mesh, double step, int numIteration, bool isVolumePreservation = true);
+	static void MeanCurvatureFlow(Mesh * mesh, double step, int numIteration, bool isVolumePreservation = true,
+		LinearSolver solver = SOLVER_AUTO, FlowState * state = NULL, bool isFixedBorder = false);
 	static void MeanCurvatureFlowExplicit(Mesh * mesh, double step, int numIteration);
 };
 
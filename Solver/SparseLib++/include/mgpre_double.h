@@ -0,0 +1,70 @@
+/*+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+/*                                                                           */
+/*   Smoothed aggregation multigrid preconditioner                           */
+/*                                                                           */
+/*   Builds a hierarchy of coarse operators from the matrix graph alone      */
+/*   and applies one symmetric V-cycle per solve(). The matrix is assumed    */
+/*   symmetric positive definite (e.g. the implicit mean curvature flow      */
+/*   system), so trans_solve() is the same operator and the preconditioner   */
+/*   can be used with CG, BiCG and friends. Used together with IR it is a    */
+/*   standalone multigrid solver.                                            */
+/*                                                                           */
+/*+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+
+#ifndef MGPRE_H
+#define MGPRE_H
+
+#include <vector>
+
+#include "vecdefs.h"
+#include VECTOR_H
+
+#include "compcol_double.h"
+
+class MultigridPreconditioner_double {
+
+ public:
+  struct SparseMatrix
+  {
+    int rows, cols;
+    std::vector<int> ptr, ind;      // compressed columns
+    std::vector<double> val;
+  };
+
+ private:
+  struct Level
+  {
+    SparseMatrix A;                 // operator on this level
+    SparseMatrix P;                 // prolongation to this level from the next
+    std::vector<double> diag;       // diagonal of A
+    std::vector<int> aggregate;     // coarse unknown of each fine unknown, -1 if isolated
+  };
+
+  std::vector<Level> levels_;
+
+  // Coarsest level is solved by a dense Cholesky factor if it is small enough
+  std::vector<double> coarseFactor_;
+  bool isCoarseDirect_;
+
+  int maxCoarseSize_;
+  int numSweeps_;
+  double strength_;
+
+  void build (const CompCol_Mat_double &A);
+  void coarsen (int level);
+  void factorCoarsest (void);
+  void cycle (int level, const double * b, double * x) const;
+
+ public:
+  MultigridPreconditioner_double (const CompCol_Mat_double &A, int maxCoarseSize = 200,
+                                  int numSweeps = 1, double strength = 0.08);
+  ~MultigridPreconditioner_double (void) { };
+
+  VECTOR_double solve (const VECTOR_double &x) const;
+  VECTOR_double trans_solve (const VECTOR_double &x) const;
+
+  int numLevels (void) const { return (int) levels_.size(); }
+  double operatorComplexity (void) const;
+};
+
+#endif
@@ -70,6 +70,7 @@ namespace Solver
 #include "diagpre_double.h"
 #include "icpre_double.h"
 #include "ilupre_double.h"
+#include "mgpre_double.h"
 
 template int  Solver::CG<class CompCol_Mat_double,class 
 MV_Vector_double,class DiagPreconditioner_double,double>
@@ -77,3 +78,8 @@ MV_Vector_double,class DiagPreconditioner_double,double>
 MV_Vector_double const &,class DiagPreconditioner_double const &,
 int &,double &);
 
+template int  Solver::CG<class CompCol_Mat_double,class 
+MV_Vector_double,class MultigridPreconditioner_double,double>
+(class CompCol_Mat_double const &,class MV_Vector_double &,class 
+MV_Vector_double const &,class MultigridPreconditioner_double const &,
+int &,double &);
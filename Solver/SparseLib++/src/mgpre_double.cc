@@ -0,0 +1,416 @@
+/*+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+/*                                                                           */
+/*   Smoothed aggregation multigrid preconditioner                           */
+/*                                                                           */
+/*+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include "mgpre_double.h"
+
+typedef MultigridPreconditioner_double::SparseMatrix SparseMatrix;
+
+// Largest system handed to the dense coarse solver
+static const int MaxDirectSize = 1000;
+
+// Sweeps used when the coarsest level is too large for the dense solver
+static const int CoarseSweeps = 20;
+
+static void Transpose(const SparseMatrix &A, SparseMatrix &T)
+{
+  T.rows = A.cols;
+  T.cols = A.rows;
+  T.ptr.assign(T.cols + 1, 0);
+  T.ind.resize(A.ind.size());
+  T.val.resize(A.val.size());
+
+  for (int k = 0; k < (int) A.ind.size(); k++)
+    T.ptr[A.ind[k] + 1]++;
+
+  for (int i = 0; i < T.cols; i++)
+    T.ptr[i + 1] += T.ptr[i];
+
+  std::vector<int> next(T.ptr.begin(), T.ptr.end() - 1);
+
+  for (int j = 0; j < A.cols; j++) {
+    for (int k = A.ptr[j]; k < A.ptr[j + 1]; k++) {
+      int dest = next[A.ind[k]]++;
+      T.ind[dest] = j;
+      T.val[dest] = A.val[k];
+    }
+  }
+}
+
+// C = A * B, all compressed columns
+static void Multiply(const SparseMatrix &A, const SparseMatrix &B, SparseMatrix &C)
+{
+  C.rows = A.rows;
+  C.cols = B.cols;
+  C.ptr.assign(C.cols + 1, 0);
+  C.ind.clear();
+  C.val.clear();
+
+  std::vector<int> marker(A.rows, -1);
+  std::vector<double> accum(A.rows, 0.0);
+  std::vector<int> pattern;
+
+  for (int j = 0; j < B.cols; j++) {
+    pattern.clear();
+
+    for (int kb = B.ptr[j]; kb < B.ptr[j + 1]; kb++) {
+      int k = B.ind[kb];
+      double b = B.val[kb];
+
+      for (int ka = A.ptr[k]; ka < A.ptr[k + 1]; ka++) {
+        int i = A.ind[ka];
+
+        if (marker[i] != j) {
+          marker[i] = j;
+          accum[i] = 0.0;
+          pattern.push_back(i);
+        }
+
+        accum[i] += A.val[ka] * b;
+      }
+    }
+
+    for (int p = 0; p < (int) pattern.size(); p++) {
+      C.ind.push_back(pattern[p]);
+      C.val.push_back(accum[pattern[p]]);
+    }
+
+    C.ptr[j + 1] = (int) C.ind.size();
+  }
+}
+
+// One Gauss-Seidel sweep. A is symmetric so column i doubles as row i.
+static void GaussSeidel(const SparseMatrix &A, const std::vector<double> &diag,
+                        const double * b, double * x, bool isForward)
+{
+  int n = A.cols;
+
+  for (int s = 0; s < n; s++) {
+    int i = isForward ? s : n - 1 - s;
+    double sum = b[i];
+
+    for (int k = A.ptr[i]; k < A.ptr[i + 1]; k++)
+      if (A.ind[k] != i)
+        sum -= A.val[k] * x[A.ind[k]];
+
+    x[i] = sum / diag[i];
+  }
+}
+
+
+MultigridPreconditioner_double::MultigridPreconditioner_double(const CompCol_Mat_double &A,
+  int maxCoarseSize, int numSweeps, double strength)
+  : isCoarseDirect_(false), maxCoarseSize_(maxCoarseSize), numSweeps_(numSweeps), strength_(strength)
+{
+  build(A);
+}
+
+
+void
+MultigridPreconditioner_double::build(const CompCol_Mat_double &C)
+{
+  levels_.clear();
+  levels_.push_back(Level());
+
+  SparseMatrix & A = levels_[0].A;
+  int n = C.dim(1), nz = C.NumNonzeros(), base = C.base();
+
+  A.rows = C.dim(0);
+  A.cols = n;
+  A.ptr.resize(n + 1);
+  A.ind.resize(nz);
+  A.val.resize(nz);
+
+  for (int j = 0; j <= n; j++)  A.ptr[j] = C.col_ptr(j) - base;
+  for (int k = 0; k < nz; k++)  { A.ind[k] = C.row_ind(k) - base; A.val[k] = C.val(k); }
+
+  // Keep coarsening while it pays off
+  while (levels_.back().A.cols > maxCoarseSize_ && levels_.size() < 20) {
+    int fine = levels_.back().A.cols;
+
+    coarsen((int) levels_.size() - 1);
+
+    if (levels_.back().A.cols == 0 || levels_.back().A.cols > 0.85 * fine) {
+      levels_.pop_back();
+      levels_.back().P = SparseMatrix();
+      break;
+    }
+  }
+
+  for (int l = 0; l < (int) levels_.size(); l++) {
+    SparseMatrix & L = levels_[l].A;
+    levels_[l].diag.assign(L.cols, 1.0);
+
+    for (int j = 0; j < L.cols; j++)
+      for (int k = L.ptr[j]; k < L.ptr[j + 1]; k++)
+        if (L.ind[k] == j && L.val[k] != 0)
+          levels_[l].diag[j] = L.val[k];
+  }
+
+  factorCoarsest();
+}
+
+
+void
+MultigridPreconditioner_double::coarsen(int level)
+{
+  const SparseMatrix & A = levels_[level].A;
+  std::vector<int> & agg = levels_[level].aggregate;
+  int n = A.cols;
+
+  std::vector<double> d(n, 0.0);
+  for (int j = 0; j < n; j++)
+    for (int k = A.ptr[j]; k < A.ptr[j + 1]; k++)
+      if (A.ind[k] == j)  d[j] = A.val[k];
+
+  // Strength of connection loosens on coarser levels
+  double theta = strength_ * pow(0.5, level);
+
+  std::vector<int> strongPtr(n + 1, 0), strong;
+  for (int i = 0; i < n; i++) {
+    for (int k = A.ptr[i]; k < A.ptr[i + 1]; k++) {
+      int j = A.ind[k];
+      if (j != i && fabs(A.val[k]) >= theta * sqrt(fabs(d[i] * d[j])))
+        strong.push_back(k);
+    }
+    strongPtr[i + 1] = (int) strong.size();
+  }
+
+  const int UNSET = -2, ISOLATED = -1;
+  agg.assign(n, UNSET);
+  int nc = 0;
+
+  // Pass 1: seed aggregates around nodes whose neighbourhood is still free
+  for (int i = 0; i < n; i++) {
+    if (strongPtr[i] == strongPtr[i + 1]) { agg[i] = ISOLATED; continue; }
+    if (agg[i] != UNSET) continue;
+
+    bool isFree = true;
+    for (int s = strongPtr[i]; s < strongPtr[i + 1] && isFree; s++)
+      if (agg[A.ind[strong[s]]] >= 0) isFree = false;
+
+    if (!isFree) continue;
+
+    agg[i] = nc;
+    for (int s = strongPtr[i]; s < strongPtr[i + 1]; s++)
+      if (agg[A.ind[strong[s]]] == UNSET) agg[A.ind[strong[s]]] = nc;
+    nc++;
+  }
+
+  // Pass 2: attach leftovers to their most strongly connected aggregate
+  std::vector<int> seeded(agg);
+  for (int i = 0; i < n; i++) {
+    if (agg[i] != UNSET) continue;
+
+    double best = 0;
+    for (int s = strongPtr[i]; s < strongPtr[i + 1]; s++) {
+      int j = A.ind[strong[s]];
+      if (seeded[j] >= 0 && fabs(A.val[strong[s]]) > best) {
+        best = fabs(A.val[strong[s]]);
+        agg[i] = seeded[j];
+      }
+    }
+  }
+
+  // Pass 3: whatever remains forms its own aggregates
+  for (int i = 0; i < n; i++) {
+    if (agg[i] != UNSET) continue;
+
+    agg[i] = nc;
+    for (int s = strongPtr[i]; s < strongPtr[i + 1]; s++)
+      if (agg[A.ind[strong[s]]] == UNSET) agg[A.ind[strong[s]]] = nc;
+    nc++;
+  }
+
+  // Tentative piecewise constant prolongation
+  SparseMatrix P0;
+  P0.rows = n;
+  P0.cols = nc;
+  P0.ptr.assign(nc + 1, 0);
+  for (int i = 0; i < n; i++)
+    if (agg[i] >= 0) P0.ptr[agg[i] + 1]++;
+  for (int c = 0; c < nc; c++)
+    P0.ptr[c + 1] += P0.ptr[c];
+  P0.ind.resize(P0.ptr[nc]);
+  P0.val.assign(P0.ptr[nc], 1.0);
+
+  std::vector<int> next(P0.ptr.begin(), P0.ptr.end() - 1);
+  for (int i = 0; i < n; i++)
+    if (agg[i] >= 0) P0.ind[next[agg[i]]++] = i;
+
+  // Smooth it with one damped Jacobi step, P = (I - w D^-1 A) P0,
+  // where the spectral radius of D^-1 A is bounded by Gershgorin
+  double rho = 0;
+  for (int i = 0; i < n; i++) {
+    double rowSum = 0;
+    for (int k = A.ptr[i]; k < A.ptr[i + 1]; k++)
+      rowSum += fabs(A.val[k]);
+    if (d[i] != 0) rho = std::max(rho, rowSum / fabs(d[i]));
+  }
+  double omega = (rho > 0) ? (4.0 / 3.0) / rho : 0;
+
+  Level & L = levels_[level];
+  Multiply(A, P0, L.P);
+
+  for (int c = 0; c < nc; c++) {
+    for (int k = L.P.ptr[c]; k < L.P.ptr[c + 1]; k++) {
+      int i = L.P.ind[k];
+      double scaled = (d[i] != 0) ? omega * L.P.val[k] / d[i] : 0;
+      L.P.val[k] = ((agg[i] == c) ? 1.0 : 0.0) - scaled;
+    }
+  }
+
+  // Galerkin coarse operator P' A P
+  SparseMatrix R, AP, coarse;
+  Transpose(L.P, R);
+  Multiply(A, L.P, AP);
+  Multiply(R, AP, coarse);
+
+  levels_.push_back(Level());
+  levels_.back().A = coarse;
+}
+
+
+void
+MultigridPreconditioner_double::factorCoarsest(void)
+{
+  const SparseMatrix & A = levels_.back().A;
+  int n = A.cols;
+
+  coarseFactor_.clear();
+  isCoarseDirect_ = false;
+
+  if (n > MaxDirectSize) return;
+
+  std::vector<double> & L = coarseFactor_;
+  L.assign(n * n, 0.0);
+
+  for (int j = 0; j < n; j++)
+    for (int k = A.ptr[j]; k < A.ptr[j + 1]; k++)
+      L[A.ind[k] * n + j] = A.val[k];
+
+  // In place dense Cholesky, lower triangle
+  for (int j = 0; j < n; j++) {
+    double sum = L[j * n + j];
+    for (int k = 0; k < j; k++)
+      sum -= L[j * n + k] * L[j * n + k];
+
+    if (sum <= 1e-14 * fabs(L[j * n + j]) || sum <= 0) {
+      coarseFactor_.clear();
+      return;
+    }
+
+    double pivot = sqrt(sum);
+    L[j * n + j] = pivot;
+
+    for (int i = j + 1; i < n; i++) {
+      double s = L[i * n + j];
+      for (int k = 0; k < j; k++)
+        s -= L[i * n + k] * L[j * n + k];
+      L[i * n + j] = s / pivot;
+    }
+  }
+
+  isCoarseDirect_ = true;
+}
+
+
+void
+MultigridPreconditioner_double::cycle(int level, const double * b, double * x) const
+{
+  const Level & L = levels_[level];
+  int n = L.A.cols;
+
+  for (int i = 0; i < n; i++)  x[i] = 0;
+
+  if (level == (int) levels_.size() - 1) {
+    if (isCoarseDirect_) {
+      const std::vector<double> & F = coarseFactor_;
+
+      for (int i = 0; i < n; i++) {
+        double s = b[i];
+        for (int k = 0; k < i; k++)  s -= F[i * n + k] * x[k];
+        x[i] = s / F[i * n + i];
+      }
+      for (int i = n - 1; i >= 0; i--) {
+        double s = x[i];
+        for (int k = i + 1; k < n; k++)  s -= F[k * n + i] * x[k];
+        x[i] = s / F[i * n + i];
+      }
+    }
+    else {
+      for (int s = 0; s < CoarseSweeps; s++) {
+        GaussSeidel(L.A, L.diag, b, x, true);
+        GaussSeidel(L.A, L.diag, b, x, false);
+      }
+    }
+    return;
+  }
+
+  for (int s = 0; s < numSweeps_; s++)
+    GaussSeidel(L.A, L.diag, b, x, true);
+
+  // Restrict residual
+  std::vector<double> r(b, b + n);
+  for (int j = 0; j < n; j++)
+    for (int k = L.A.ptr[j]; k < L.A.ptr[j + 1]; k++)
+      r[L.A.ind[k]] -= L.A.val[k] * x[j];
+
+  int nc = L.P.cols;
+  std::vector<double> rc(nc, 0.0), xc(nc, 0.0);
+
+  #pragma omp parallel for
+  for (int c = 0; c < nc; c++) {
+    double s = 0;
+    for (int k = L.P.ptr[c]; k < L.P.ptr[c + 1]; k++)
+      s += L.P.val[k] * r[L.P.ind[k]];
+    rc[c] = s;
+  }
+
+  cycle(level + 1, &rc[0], &xc[0]);
+
+  // Prolongate correction
+  for (int c = 0; c < nc; c++)
+    for (int k = L.P.ptr[c]; k < L.P.ptr[c + 1]; k++)
+      x[L.P.ind[k]] += L.P.val[k] * xc[c];
+
+  for (int s = 0; s < numSweeps_; s++)
+    GaussSeidel(L.A, L.diag, b, x, false);
+}
+
+
+VECTOR_double
+MultigridPreconditioner_double::solve (const VECTOR_double &x) const
+{
+  VECTOR_double y(x.size(), 0.0);
+
+  if (x.size() > 0)
+    cycle(0, &x(0), &y(0));
+
+  return y;
+}
+
+
+VECTOR_double
+MultigridPreconditioner_double::trans_solve (const VECTOR_double &x) const
+{
+  // Symmetric V-cycle
+  return solve(x);
+}
+
+
+double
+MultigridPreconditioner_double::operatorComplexity (void) const
+{
+  double total = 0;
+
+  for (int l = 0; l < (int) levels_.size(); l++)
+    total += levels_[l].A.val.size();
+
+  return (levels_.empty() || levels_[0].A.val.empty()) ? 0 : total / levels_[0].A.val.size();
+}
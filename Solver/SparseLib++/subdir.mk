@@ -13,6 +13,7 @@ src/coord_double.cc \
 src/diagpre_double.cc \
 src/icpre_double.cc \
 src/ilupre_double.cc \
+src/mgpre_double.cc \
 src/iohb_double.cc \
 src/iotext_double.cc \
 src/mvblasd.cc \
@@ -39,6 +40,7 @@ src/coord_double.o \
 src/diagpre_double.o \
 src/icpre_double.o \
 src/ilupre_double.o \
+src/mgpre_double.o \
 src/iohb_double.o \
 src/iotext_double.o \
 src/mvblasd.o \
@@ -64,6 +66,7 @@ src/coord_double.d \
 src/diagpre_double.d \
 src/icpre_double.d \
 src/ilupre_double.d \
+src/mgpre_double.d \
 src/iohb_double.d \
 src/iotext_double.d \
 src/mvblasd.d \
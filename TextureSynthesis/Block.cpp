@@ -1,31 +1,33 @@
 #include "Block.h"
 
-#include <QImage>
-#include <QPainter>
-
 namespace Synth
 {
 	Block::Block()
 	{
 		this->p = Point(-1, -1);
 		this->src = NULL;
+		this->context = NULL;
 		this->type = NONE_BLOCK;
 	}
 
-	Block::Block(Point point, MatrixXf * source, BlockType newType)
+	Block::Block(Point point, MatrixXf * source, BlockType newType, const SynthesisContext * context)
 	{
 		this->p = point;
 		this->src = source;
 		this->type = newType;
+		this->context = context;
 	}
 
-	void Block::paste(int u, int v, MatrixXf * target, Vector<Vector<Point> > * targetAsPos)
+	void Block::paste(int u, int v, MatrixXf * target, Vector<Vector<Point> > * targetAsPos, CutMask * cut)
 	{
 		setUV(u, v);
 
+		int BlockSize = context->blockSize;
+
                 float final;
 
-		MatrixXf mask = getCutMask(u, v, target);
+		CutMask localCut;
+		const MatrixXf & mask = getCutMask(u, v, target, cut ? *cut : localCut);
 
 		for(int y = 0; y < BlockSize; y++)
 		{
@@ -45,6 +47,8 @@ namespace Synth
 
 	void Block::setUV(int & x, int & y)
 	{
+		int BandSize = context->bandSize;
+
 		if(type == L_SHAPED || type == N_SHAPED)
 		{
 			x -= (BandSize - 1);
@@ -56,18 +60,16 @@ namespace Synth
 		}
 	}
 
-	MatrixXf Block::getCutMask(int u, int v, MatrixXf * target)
+	const MatrixXf & Block::getCutMask(int u, int v, MatrixXf * target, CutMask & cut)
 	{
-		MatrixXf difference = src->block(p.y, p.x, BlockSize, BlockSize) - target->block(v, u, BlockSize, BlockSize);
-		MatrixXf overlap = difference.array().square();
+		int BlockSize = context->blockSize;
 
-		MatrixXf mask = MatrixXf::Ones(BlockSize, BlockSize);
+		// Sized buffers are assigned in place
+		MatrixXf & overlap = cut.overlap;
+		overlap = (src->block(p.y, p.x, BlockSize, BlockSize) - target->block(v, u, BlockSize, BlockSize)).array().square();
 
-		// Find best cut
-		if(overlap.sum() != 0)
-		{
-			CutMask cut = CutMask(overlap, type);
-			mask = cut.getMask();
+		// Find best cut, no overlap error means no cut
+		const MatrixXf & mask = cut.compute(overlap, overlap.sum() != 0 ? type : NONE_BLOCK, *context);
 
 			/*
 			QImage * img = new QImage(BlockSize, BlockSize, QImage::Format_RGB32);
@@ -84,7 +86,6 @@ namespace Synth
 			sprintf(fileName, "mask_%d_%d.png", (int)type, xxxxx);
 			img->save(fileName);
 			*/
-		}
 
 		return mask;
 	}
@@ -11,17 +11,19 @@ namespace Synth
 	private:
 		
 		MatrixXf * src;
+		const SynthesisContext * context;
 
 	public:
 		BlockType type;
 
 		Block();
-		Block(Point point, MatrixXf * source, BlockType newType);
+		Block(Point point, MatrixXf * source, BlockType newType, const SynthesisContext * context);
 
-		void paste(int u, int v, MatrixXf * target, Vector<Vector<Point> > * targetAsPos);
+		// 'cut' holds the seam solver's scratch, pass one to reuse it across blocks
+		void paste(int u, int v, MatrixXf * target, Vector<Vector<Point> > * targetAsPos, CutMask * cut = NULL);
 		
 		void setUV(int & x, int & y);
-		MatrixXf getCutMask(int u, int v, MatrixXf * target);
+		const MatrixXf & getCutMask(int u, int v, MatrixXf * target, CutMask & cut);
 
 		Point p; // faster??
 		inline int y() {return p.y;}
@@ -0,0 +1,245 @@
+#include "BlockMatcher.h"
+
+#include <math.h>
+
+namespace Synth
+{
+
+static int nextPowerOfTwo(int n)
+{
+	int p = 1;
+	while(p < n) p <<= 1;
+	return p;
+}
+
+// Twiddle factors exp(-2 pi i k / n), k < n / 2
+static Vector<Complex> twiddles(int n)
+{
+	Vector<Complex> w(Max(1, n / 2));
+
+	for(int k = 0; k < n / 2; k++)
+		w[k] = Complex(cos(2.0 * M_PI * k / n), -sin(2.0 * M_PI * k / n));
+
+	return w;
+}
+
+// In-place radix-2 transform of n contiguous values, unscaled
+static void fft(Complex * a, int n, const Vector<Complex> & w, bool inverse)
+{
+	// Bit reversal
+	for(int i = 1, j = 0; i < n; i++)
+	{
+		int bit = n >> 1;
+		for(; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+
+		if(i < j) std::swap(a[i], a[j]);
+	}
+
+	for(int len = 2; len <= n; len <<= 1)
+	{
+		int half = len / 2;
+		int step = n / len;
+
+		for(int i = 0; i < n; i += len)
+		{
+			for(int j = 0; j < half; j++)
+			{
+				Complex t = a[i + j + half] * (inverse ? std::conj(w[j * step]) : w[j * step]);
+				a[i + j + half] = a[i + j] - t;
+				a[i + j] += t;
+			}
+		}
+	}
+}
+
+// 2D transform, only the first 'usedRows' rows of the input (forward) or
+// output (inverse) matter, the others are zero / ignored
+void BlockMatcher::fft2D(Vector<Complex> & a, int usedRows, bool inverse)
+{
+	Vector<Complex> column(fftRows);
+
+	if(!inverse)
+	{
+		for(int y = 0; y < usedRows; y++)
+			fft(&a[y * fftCols], fftCols, rowTwiddles, false);
+	}
+
+	for(int x = 0; x < fftCols; x++)
+	{
+		for(int y = 0; y < fftRows; y++) column[y] = a[y * fftCols + x];
+
+		fft(&column[0], fftRows, columnTwiddles, inverse);
+
+		for(int y = 0; y < fftRows; y++) a[y * fftCols + x] = column[y];
+	}
+
+	if(inverse)
+	{
+		double scale = 1.0 / ((double)fftRows * fftCols);
+
+		for(int y = 0; y < usedRows; y++)
+		{
+			fft(&a[y * fftCols], fftCols, rowTwiddles, true);
+
+			for(int x = 0; x < fftCols; x++)
+				a[y * fftCols + x] *= scale;
+		}
+	}
+}
+
+BlockMatcher::BlockMatcher()
+{
+	blockSize = 0;
+	fftRows = fftCols = 0;
+	targetEnergy = queryMaxEnergy = 0;
+	queryType = NONE_BLOCK;
+	mapCount = 0;
+}
+
+void BlockMatcher::init(const MatrixXf & source, int blockSize)
+{
+	this->src = source;
+	this->blockSize = blockSize;
+
+	fftRows = nextPowerOfTwo(source.rows());
+	fftCols = nextPowerOfTwo(source.cols());
+
+	rowTwiddles = twiddles(fftCols);
+	columnTwiddles = twiddles(fftRows);
+
+	// Spectra of the source and its square, zero padded
+	srcSpectrum = Vector<Complex>(fftRows * fftCols, Complex(0, 0));
+	srcSquaredSpectrum = srcSpectrum;
+
+	for(int y = 0; y < source.rows(); y++)
+	{
+		for(int x = 0; x < source.cols(); x++)
+		{
+			double v = source(y,x);
+			srcSpectrum[y * fftCols + x] = Complex(v, 0);
+			srcSquaredSpectrum[y * fftCols + x] = Complex(v * v, 0);
+		}
+	}
+
+	fft2D(srcSpectrum, source.rows(), false);
+	fft2D(srcSquaredSpectrum, source.rows(), false);
+
+	energy.clear();
+	maxEnergy.clear();
+	mapCount = 0;
+}
+
+void BlockMatcher::correlate(const Vector<Complex> & spectrum, const MatrixXf & kernel, MatrixXd & result)
+{
+	Vector<Complex> k(fftRows * fftCols, Complex(0, 0));
+
+	for(int y = 0; y < kernel.rows(); y++)
+		for(int x = 0; x < kernel.cols(); x++)
+			k[y * fftCols + x] = Complex(kernel(y,x), 0);
+
+	fft2D(k, kernel.rows(), false);
+
+	// sum_x src(x + d) k(x)  <=>  F(src) * conj(F(k))
+	for(int i = 0; i < (int)k.size(); i++)
+		k[i] = spectrum[i] * std::conj(k[i]);
+
+	result = MatrixXd(src.rows() - blockSize + 1, src.cols() - blockSize + 1);
+
+	fft2D(k, result.rows(), true);
+
+	for(int y = 0; y < result.rows(); y++)
+		for(int x = 0; x < result.cols(); x++)
+			result(y,x) = k[y * fftCols + x].real();
+}
+
+void BlockMatcher::setBlock(BlockType type, const MatrixXf & weight, const MatrixXf & targetBlock)
+{
+	queryType = type;
+	queryWeight = weight;
+	targetEnergy = 0;
+
+	query.clear();
+
+	for(int y = 0; y < weight.rows(); y++)
+	{
+		for(int x = 0; x < weight.cols(); x++)
+		{
+			if(weight(y,x) == 0) continue;
+
+			WeightedPixel p;
+			p.x = x;
+			p.y = y;
+			p.w = weight(y,x);
+			p.t = targetBlock(y,x);
+			query.push_back(p);
+
+			targetEnergy += (double)p.w * p.t * p.t;
+		}
+	}
+}
+
+float BlockMatcher::score(int x, int y) const
+{
+	float sum = 0;
+
+	for(int i = 0; i < (int)query.size(); i++)
+	{
+		const WeightedPixel & p = query[i];
+		float d = src(y + p.y, x + p.x) - p.t;
+		sum += p.w * d * d;
+	}
+
+	return sum;
+}
+
+const MatrixXf & BlockMatcher::scoreMap()
+{
+	// Weights only depend on the block type, so is the energy term
+	if(energy.find(queryType) == energy.end())
+	{
+		correlate(srcSquaredSpectrum, queryWeight, energy[queryType]);
+		maxEnergy[queryType] = energy[queryType].maxCoeff();
+	}
+
+	queryMaxEnergy = maxEnergy[queryType];
+
+	MatrixXf weightedTarget = MatrixXf::Zero(blockSize, blockSize);
+	for(int i = 0; i < (int)query.size(); i++)
+		weightedTarget(query[i].y, query[i].x) = query[i].w * query[i].t;
+
+	MatrixXd cross;
+	correlate(srcSpectrum, weightedTarget, cross);
+
+	const MatrixXd & e = energy[queryType];
+
+	map = MatrixXf(e.rows(), e.cols());
+
+	for(int y = 0; y < map.rows(); y++)
+		for(int x = 0; x < map.cols(); x++)
+			map(y,x) = (float)(e(y,x) - 2.0 * cross(y,x) + targetEnergy);
+
+	mapCount++;
+
+	return map;
+}
+
+float BlockMatcher::tolerance(float minScore) const
+{
+	// Round-off of the expanded sum (and of the direct float sum) grows with
+	// the magnitude of its terms
+	return 1e-5f * fabs(minScore) + 1e-6f * (float)(queryMaxEnergy + targetEnergy);
+}
+
+bool BlockMatcher::isMapCheaper(int candidates) const
+{
+	// Measured: a forward and an inverse transform cost about 2.5 n log2(n)
+	// weighted pixel differences
+	double n = (double)fftRows * fftCols;
+	double mapCost = 2.5 * n * log(n) / log(2.0);
+	double directCost = (double)candidates * query.size();
+
+	return mapCost < directCost;
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <complex>
+
+#include "Globals.h"
+
+namespace Synth
+{
+	typedef std::complex<double> Complex;
+
+	// Weighted SSD between a target block and source blocks:
+	//	S(d) = sum w (src(x+d) - t)^2
+	//	     = sum w src(x+d)^2  -  2 sum (w t) src(x+d)  +  sum w t^2
+	// The first two terms are correlations with the source, computed for all
+	// offsets at once by FFT. Small candidate sets are scored directly.
+	class BlockMatcher
+	{
+		private:
+			MatrixXf src;
+			int blockSize;
+
+			// Padded (power of two) FFT size, row-major spectra
+			int fftRows, fftCols;
+			Vector<Complex> srcSpectrum;
+			Vector<Complex> srcSquaredSpectrum;
+			Vector<Complex> rowTwiddles, columnTwiddles;
+
+			// sum w src^2 at every offset, per block type
+			StdMap<int, MatrixXd> energy;
+			StdMap<int, double> maxEnergy;
+
+			// Current query, non-zero weights only
+			struct WeightedPixel
+			{
+				int x, y;
+				float w, t;
+			};
+			Vector<WeightedPixel> query;
+			BlockType queryType;
+			MatrixXf queryWeight;
+			double targetEnergy;
+			double queryMaxEnergy;
+
+			MatrixXf map;
+
+			void fft2D(Vector<Complex> & a, int usedRows, bool inverse);
+			void correlate(const Vector<Complex> & spectrum, const MatrixXf & kernel, MatrixXd & result);
+
+		public:
+			BlockMatcher();
+
+			void init(const MatrixXf & source, int blockSize);
+
+			// Set the block to look for, weights outside the overlap are zero
+			void setBlock(BlockType type, const MatrixXf & weight, const MatrixXf & targetBlock);
+
+			// Direct score of the block at (x,y)
+			float score(int x, int y) const;
+
+			// Scores of all block positions, (rows - blockSize + 1) x (cols - blockSize + 1)
+			const MatrixXf & scoreMap();
+
+			// Map entries closer than this to the minimum need a direct check
+			float tolerance(float minScore) const;
+
+			bool isMapCheaper(int candidates) const;
+
+			int mapCount;
+	};
+}
@@ -0,0 +1,230 @@
+#include "CoherenceSynthesizer.h"
+
+#include <math.h>
+
+namespace Synth
+{
+
+CoherenceSynthesizer::CoherenceSynthesizer(int radius, int iterations, unsigned int seed)
+{
+	this->radius = Max(1, radius);
+	this->iterations = Max(1, iterations);
+	this->seed = seed;
+}
+
+Vector<Vector<Point> > CoherenceSynthesizer::synthesizeAsPos(const MatrixXf & source, int pad, int width, int block)
+{
+	this->src = source;
+
+	int rows = src.rows();
+	int cols = Max(width, (int)src.cols());
+	block = Max(4, Min(block, (int)Min(src.rows(), src.cols()) - 1));
+
+	// Same layout as the patch-based synthesizer: left half and right half
+	// of the source at both ends of the target
+	int cut = ceil(src.cols() / 2.0f) - 1;
+	int jump = cols - src.cols();
+
+	// Initial guess: full height source strips of one block width. Each
+	// strip is the best of a few random ones at continuing the previous strip
+	Vector<int> origins;
+	int next = cut;
+
+	for(int i = 0; i * block <= jump; i++)
+	{
+		int best = 0;
+		float minCost = FLT_MAX;
+
+		for(int j = 0; j < COHERENCE_INIT_CANDIDATES; j++)
+		{
+			int origin = random(i, j, 0, 0) % (src.cols() - block + 1);
+			float cost = (src.col(Min(next, (int)src.cols() - 1)) - src.col(origin)).squaredNorm();
+
+			if(cost < minCost)
+			{
+				minCost = cost;
+				best = origin;
+			}
+		}
+
+		origins.push_back(best);
+		next = best + block;
+	}
+
+	targetAsPos = Vector<Vector<Point> >(rows, Vector<Point>(cols));
+	Vector<Vector<char> > isFixed(rows, Vector<char>(cols, 1));
+
+	for(int y = 0; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			if(x < cut)
+				targetAsPos[y][x] = Point(x, y);
+			else if(x >= cut + jump)
+				targetAsPos[y][x] = Point(x - jump, y);
+			else
+			{
+				int i = (x - cut) / block;
+
+				targetAsPos[y][x] = Point(origins[i] + (x - cut) - i * block, y);
+				isFixed[y][x] = 0;
+			}
+		}
+	}
+
+	target = MatrixXf(rows, cols);
+
+	for(int y = 0; y < rows; y++)
+		for(int x = 0; x < cols; x++)
+			target(y,x) = src(targetAsPos[y][x].y, targetAsPos[y][x].x);
+
+	int searchRadius = Max(src.rows(), src.cols());
+
+	for(int it = 0; it < iterations; it++)
+	{
+		// Neighbourhoods are matched against the previous result, rows only
+		// read their own new positions so the result does not depend on threads
+		MatrixXf guide = target;
+		Vector<Vector<Point> > previous = targetAsPos;
+
+		bool isForward = (it % 2 == 0);
+
+		#pragma omp parallel for schedule(dynamic)
+		for(int y = 0; y < rows; y++)
+		{
+			for(int k = 0; k < cols; k++)
+			{
+				int x = isForward ? k : cols - 1 - k;
+
+				if(isFixed[y][x]) continue;
+
+				Point best = targetAsPos[y][x];
+				float minDistance = distance(guide, best, x, y, FLT_MAX);
+
+				// Inside a coherent patch nothing would change
+				if(minDistance == 0) continue;
+
+				// Coherent candidates: continue the patch of each neighbour, the
+				// previous pixel of the row is already matched in this pass
+				for(int dy = -1; dy <= 1; dy++)
+				{
+					for(int dx = -1; dx <= 1; dx++)
+					{
+						int nx = x + dx, ny = y + dy;
+						if((!dx && !dy) || nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+
+						const Point & n = (dy == 0) ? targetAsPos[ny][nx] : previous[ny][nx];
+						Point q(n.x - dx, n.y - dy);
+
+						if(!isValid(q) || (q.x == best.x && q.y == best.y)) continue;
+
+						float d = distance(guide, q, x, y, minDistance);
+
+						if(d < minDistance)
+						{
+							minDistance = d;
+							best = q;
+						}
+					}
+				}
+
+				// Random search around the best match, shrinking window
+				int i = 0;
+				for(int r = searchRadius; r >= 1; r /= 2, i++)
+				{
+					Point q(best.x + (int)(random(x, y, it, 2 * i) % (2 * r + 1)) - r,
+						best.y + (int)(random(x, y, it, 2 * i + 1) % (2 * r + 1)) - r);
+
+					if(!isValid(q)) continue;
+
+					float d = distance(guide, q, x, y, minDistance);
+
+					if(d < minDistance)
+					{
+						minDistance = d;
+						best = q;
+					}
+				}
+
+				targetAsPos[y][x] = best;
+			}
+		}
+
+		for(int y = 0; y < rows; y++)
+			for(int x = 0; x < cols; x++)
+				target(y,x) = src(targetAsPos[y][x].y, targetAsPos[y][x].x);
+	}
+
+	// Crop like PatchSynthesizer::crop
+	int heightCrop = rows - pad;
+
+	MatrixXf temp = target.block(0, 0, heightCrop, cols);
+	target = temp;
+
+	targetAsPos.resize(heightCrop);
+
+	for(int y = 0; y < heightCrop; y++)
+		for(int x = 0; x < cols; x++)
+			targetAsPos[y][x].y %= heightCrop;
+
+	return targetAsPos;
+}
+
+float CoherenceSynthesizer::distance(const MatrixXf & guide, Point q, int x, int y, float bound)
+{
+	float sum = 0;
+
+	for(int dy = -radius; dy <= radius; dy++)
+	{
+		int ty = y + dy;
+		if(ty < 0 || ty >= guide.rows()) continue;
+
+		// Source is clamped at its border, so every candidate of a pixel
+		// sums the same number of terms
+		int sy = Min(Max(q.y + dy, 0), (int)src.rows() - 1);
+
+		for(int dx = -radius; dx <= radius; dx++)
+		{
+			int tx = x + dx;
+			if(tx < 0 || tx >= guide.cols()) continue;
+
+			int sx = Min(Max(q.x + dx, 0), (int)src.cols() - 1);
+
+			float diff = src(sy, sx) - guide(ty, tx);
+			sum += diff * diff;
+		}
+
+		// Already worse than the best match
+		if(sum >= bound) return sum;
+	}
+
+	return sum;
+}
+
+bool CoherenceSynthesizer::isValid(const Point & q)
+{
+	return q.x >= 0 && q.y >= 0 && q.x < src.cols() && q.y < src.rows();
+}
+
+unsigned int CoherenceSynthesizer::random(unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+{
+	// Hash of the arguments, the same for any thread order
+	unsigned int h = seed * 0x9E3779B9u;
+	h ^= a * 0x85EBCA6Bu; h = (h << 13) | (h >> 19);
+	h ^= b * 0xC2B2AE35u; h = (h << 13) | (h >> 19);
+	h ^= c * 0x27D4EB2Fu; h = (h << 13) | (h >> 19);
+	h ^= d * 0x165667B1u;
+
+	h ^= h >> 16; h *= 0x85EBCA6Bu;
+	h ^= h >> 13; h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+
+	return h;
+}
+
+MatrixXf CoherenceSynthesizer::result()
+{
+	return target;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Globals.h"
+
+// Random strips tried for each strip of the initial guess
+#define COHERENCE_INIT_CANDIDATES 16
+
+namespace Synth
+{
+	// PatchMatch style synthesis on the position map. The two copied source
+	// pieces are fixed, the gap between them starts as source strips picked
+	// at random. Each iteration re-matches every free pixel's neighbourhood
+	// against candidates from its neighbours' positions (coherence) and a
+	// few random ones around its current match. Rows run in parallel.
+	class CoherenceSynthesizer
+	{
+		private:
+			int radius;
+			int iterations;
+			unsigned int seed;
+
+			MatrixXf src;
+			MatrixXf target;
+			Vector<Vector<Point> > targetAsPos;
+
+			float distance(const MatrixXf & guide, Point q, int x, int y, float bound);
+			bool isValid(const Point & q);
+			unsigned int random(unsigned int a, unsigned int b, unsigned int c, unsigned int d);
+
+		public:
+			// 'radius' of the matched neighbourhood, 'seed' makes the random choices
+			CoherenceSynthesizer(int radius = 2, int iterations = 2, unsigned int seed = 1);
+
+			Vector<Vector<Point> > synthesizeAsPos(const MatrixXf & source, int pad, int width, int block);
+
+			MatrixXf result();
+	};
+}
@@ -1,116 +1,167 @@
 #include "CutMask.h"
 
-CutMask::CutMask(MatrixXf & overlap, BlockType type)
+#include <algorithm>
+#include <limits>
+
+CutMask::CutMask()
 {
-	for(int y = 0; y < BlockSize; y++)
-	{
-		for(int x = 0; x < BlockSize; x++)
-		{
-			points[nodes.size()] = Point(x,y);
-			nodes[Point(x,y)] = nodes.size();
-		}
-	}
+	BlockSize = BandSize = 0;
+}
 
-	protectCore(overlap, type);
+CutMask::CutMask(MatrixXf & overlap, BlockType type, const SynthesisContext & context)
+{
+	BlockSize = BandSize = 0;
 
-	costMatrix = overlap;
+	compute(overlap, type, context);
+}
 
-	for(int y = 0; y < BlockSize; y++)
-	{
-		for(int x = 0; x < BlockSize; x++)
-		{
-			Point p1 = Point(x    , y    );
-			Point p2 = Point(x + 1, y    );
-			Point p3 = Point(x    , y + 1);
+void CutMask::resize(const SynthesisContext & context)
+{
+	BandSize = context.bandSize;
 
-			if(point(p2))	g.AddEdge(nodes[p1], nodes[p2], cost(p1,p2));
-			if(point(p3))	g.AddEdge(nodes[p1], nodes[p3], cost(p1,p3));
-		}
-	}
+	if(BlockSize == context.blockSize) return;
+
+	BlockSize = context.blockSize;
 
-	// Add start and end nodes
-	int start = nodes.size();
-	int end = start + 1;
+	int n = BlockSize * BlockSize + 2;
+
+	distance.resize(n);
+	previous.resize(n);
+	visited.resize(n);
+
+	queue.reserve(4 * n);
+	stack.reserve(n);
+
+	mask = MatrixXf::Ones(BlockSize, BlockSize);
+}
+
+const MatrixXf & CutMask::compute(MatrixXf & overlap, BlockType type, const SynthesisContext & context)
+{
+	resize(context);
+
+	protectCore(overlap, type);
+
+	mask.setOnes();
 
 	BlockType originalType = type;
-	
+
+	// V_BOTHSIDES is cut as N_SHAPED with a free top row in between
+	if(originalType == V_BOTHSIDES)
+		type = N_SHAPED;
+
+	if(type != VERTICAL && type != L_SHAPED && type != N_SHAPED)
+		return mask;
+
+	shortestPath(overlap, type, originalType == V_BOTHSIDES);
+
+	// turn into boolean mask, start and end nodes are not pixels
+	int start = BlockSize * BlockSize;
+
+	for(int i = previous[start + 1]; i != start && i >= 0; i = previous[i])
+		mask(i / BlockSize, i % BlockSize) = 0;
+
+	fillMask(mask, type);
+
+	// Special case: fix V_BOTHSIDES mask
 	if(originalType == V_BOTHSIDES)
 	{
-		// convert it to N_SHAPED
-		for(int i = BandSize - 1; i < BlockSize - BandSize; i++)
+		for(int i = BandSize; i < BlockSize - BandSize; i++)
 		{
-			g.SetEdgeWeight(nodes[Point(i,0)], nodes[Point(i+1,0)], 0);
-			g.SetEdgeWeight(nodes[Point(i+1,0)], nodes[Point(i,0)], 0);
+			mask(0, i) = 1.0f;
 		}
+	}
 
-		type = N_SHAPED;
+	return mask;
+}
+
+void CutMask::relax(int u, int v, float weight)
+{
+	float d = distance[u] + weight;
+
+	if(d < distance[v])
+	{
+		distance[v] = d;
+		previous[v] = u;
+
+		QueueEntry e;
+		e.distance = d;
+		e.node = v;
+		queue.push_back(e);
+		std::push_heap(queue.begin(), queue.end());
 	}
+}
+
+void CutMask::shortestPath(const MatrixXf & costMatrix, BlockType type, bool isBothSides)
+{
+	int n = BlockSize * BlockSize;
+	int start = n;
+	int end = n + 1;
 
-	// connect start and end to graph, first is start node case
+	std::fill(distance.begin(), distance.end(), std::numeric_limits<float>::infinity());
+	std::fill(previous.begin(), previous.end(), -1);
+	std::fill(visited.begin(), visited.end(), 0);
+	queue.clear();
+
+	distance[start] = 0;
+	visited[start] = 1;
+
+	// connect start to graph
 	switch(type)
 	{
 	case VERTICAL:
 		for(int i = 0; i < BandSize; i++)
-			g.AddEdge(start, nodes[Point(i, 0)], 0);
+			relax(start, i, 0);
 		break;
 
 	case L_SHAPED:
-		//for(int i = 0; i < BandSize; i++)
-		//	g.AddEdge(start, nodes[Point(BlockSize - 1, i)], 0);
-		g.AddEdge(start, nodes[Point(BlockSize - 1, BandSize - 1)], 0);
+		relax(start, (BandSize - 1) * BlockSize + (BlockSize - 1), 0);
 		break;
 
 	case N_SHAPED:
 		for(int i = 0; i < BandSize; i++)
-			g.AddEdge(start, nodes[Point((BlockSize - 1) - i, BlockSize - 1)], 0);
+			relax(start, (BlockSize - 1) * BlockSize + (BlockSize - 1) - i, 0);
 		break;
 
-        case NONE_BLOCK:
-        case V_BOTHSIDES:
-        case HORIZONTAL:
-                break;
+	default:
+		break;
 	}
 
-	// end node connections
-	for(int i = 0; i < BandSize; i++)
-		g.AddEdge(end, nodes[Point(i, BlockSize - 1)], 0);
+	// Nodes leave the queue ordered by distance then index, as with the
+	// generic graph, so equal cost paths are broken the same way
+	while(!queue.empty())
+	{
+		int u = queue.front().node;
+		std::pop_heap(queue.begin(), queue.end());
+		queue.pop_back();
 
-	// Find the shortest path
-	std::list<int> path = g.DijkstraShortestPath(start, end);
+		if(visited[u]) continue;
+		visited[u] = 1;
 
-	// Remove start and end points
-	path.pop_front();
-	path.pop_back();
+		if(u == end) break;
 
-	// turn into boolean mask
-	mask = MatrixXf::Ones(BlockSize, BlockSize);
+		int x = u % BlockSize;
+		int y = u / BlockSize;
+		float c = costMatrix(y, x);
 
-	for(std::list<int>::iterator i = path.begin(); i != path.end(); i++)
-	{
-		Point p = points[*i];
-		mask(p.y, p.x) = 0;
-	}
-
-	fillMask(mask, type);
+		if(x + 1 < BlockSize)
+		{
+			bool isFree = isBothSides && y == 0 && x >= BandSize - 1 && x < BlockSize - BandSize;
+			relax(u, u + 1, isFree ? 0 : c + costMatrix(y, x + 1));
+		}
 
-	// Special case: fix V_BOTHSIDES mask
-	if(originalType == V_BOTHSIDES)
-	{
-		for(int i = BandSize; i < BlockSize - BandSize; i++)
+		if(x > 0)
 		{
-			mask(0, i) = 1.0f;
+			bool isFree = isBothSides && y == 0 && x - 1 >= BandSize - 1 && x - 1 < BlockSize - BandSize;
+			relax(u, u - 1, isFree ? 0 : c + costMatrix(y, x - 1));
 		}
-	}
-}
 
-float CutMask::cost(Point p1, Point p2)
-{
-	return costMatrix(p1.y, p1.x) + costMatrix(p2.y, p2.x);
-}
+		if(y + 1 < BlockSize)	relax(u, u + BlockSize, c + costMatrix(y + 1, x));
+		if(y > 0)				relax(u, u - BlockSize, c + costMatrix(y - 1, x));
 
-bool CutMask::point(Point p)
-{
-	return (nodes.find(p) != nodes.end());
+		// end node connections
+		if(y == BlockSize - 1 && x < BandSize)
+			relax(u, end, 0);
+	}
 }
 
 void CutMask::protectCore(MatrixXf & overlap, BlockType type)
@@ -118,26 +169,26 @@ void CutMask::protectCore(MatrixXf & overlap, BlockType type)
 	switch(type)
 	{
 	case VERTICAL:
-                overlap.block(0, BandSize, BlockSize, BlockSize - BandSize) = MatrixXf::Constant(BlockSize, BlockSize - BandSize, FLT_MAX);
+		overlap.block(0, BandSize, BlockSize, BlockSize - BandSize).setConstant(FLT_MAX);
 		break;
 
 	case V_BOTHSIDES:
 		{
 			int width = BlockSize - (2 * BandSize);
-			overlap.block(0, BandSize, BlockSize, width) = MatrixXf::Constant(BlockSize, width, FLT_MAX);
+			overlap.block(0, BandSize, BlockSize, width).setConstant(FLT_MAX);
 		}break;
 
 	case L_SHAPED:
 		{
 			int size = BlockSize - BandSize;
-			overlap.block(BandSize, BandSize, size, size) = MatrixXf::Constant(size, size, FLT_MAX);
+			overlap.block(BandSize, BandSize, size, size).setConstant(FLT_MAX);
 		}break;
 
 	case N_SHAPED:
 		{
 			int width = BlockSize - (2 * BandSize);
 			int height = BlockSize - BandSize;
-			overlap.block(BandSize, BandSize, height, width) = MatrixXf::Constant(height, width, FLT_MAX);
+			overlap.block(BandSize, BandSize, height, width).setConstant(FLT_MAX);
 		}break;
 
         case NONE_BLOCK:
@@ -185,15 +236,26 @@ void CutMask::fillMask(MatrixXf & m, BlockType type)
 
 void CutMask::fillMask(int x, int y, MatrixXf & m)
 {
-	if(x >= 0 && x < BlockSize && y >= 0 && y < BlockSize && m(y,x) == 1)
+	if(m(y,x) != 1) return;
+
+	// Flood fill with an explicit stack
+	stack.clear();
+	stack.push_back(y * BlockSize + x);
+	m(y,x) = 0;
+
+	while(!stack.empty())
 	{
-		m(y,x) = 0; 
+		int i = stack.back();
+		stack.pop_back();
 
-		fillMask(x + 1, y,     m);       
-		fillMask(x - 1, y,     m);       
-		fillMask(x,     y + 1, m);
-		fillMask(x,     y - 1, m);              
-	}   
+		int px = i % BlockSize;
+		int py = i / BlockSize;
+
+		if(px + 1 < BlockSize	&& m(py, px + 1) == 1)	{ m(py, px + 1) = 0; stack.push_back(i + 1); }
+		if(px > 0				&& m(py, px - 1) == 1)	{ m(py, px - 1) = 0; stack.push_back(i - 1); }
+		if(py + 1 < BlockSize	&& m(py + 1, px) == 1)	{ m(py + 1, px) = 0; stack.push_back(i + BlockSize); }
+		if(py > 0				&& m(py - 1, px) == 1)	{ m(py - 1, px) = 0; stack.push_back(i - BlockSize); }
+	}
 }
 
 MatrixXf CutMask::getMask()
@@ -1,27 +1,54 @@
 #pragma once
 
 #include "Globals.h"
-#include "Utility/Graph.h"
 
+// Minimum error boundary cut of a block's overlap, Dijkstra on the implicit
+// 4-connected pixel grid. Scratch buffers are kept between calls, reuse one
+// CutMask for all blocks of a synthesis to avoid allocating per block.
 class CutMask
 {
-	MatrixXf costMatrix;
-	float cost(Point p1, Point p2);
-
-	Graph<int, float> g;
-	StdMap<Point, int> nodes;
-	StdMap<int, Point> points;
+	int BlockSize;
+	int BandSize;
 
 	MatrixXf mask;
 
-	bool point(Point p);
+	// Grid nodes are y * BlockSize + x, then the start and end nodes
+	Vector<float> distance;
+	Vector<int> previous;
+	Vector<char> visited;
+
+	struct QueueEntry
+	{
+		float distance;
+		int node;
+
+		// Reversed for std heaps: smallest distance, then smallest node first
+		bool operator< (const QueueEntry & e) const
+		{
+			if(distance == e.distance) return node > e.node;
+			return distance > e.distance;
+		}
+	};
+	Vector<QueueEntry> queue;
+	Vector<int> stack;
+
+	void resize(const SynthesisContext & context);
+	void relax(int u, int v, float weight);
+	void shortestPath(const MatrixXf & costMatrix, BlockType type, bool isBothSides);
+
 	void protectCore(MatrixXf & overlap, BlockType type);
 
 	void fillMask(MatrixXf & m, BlockType type);
 	void fillMask(int x, int y, MatrixXf & m);
 
 public:
-	CutMask(MatrixXf & overlap, BlockType type);
-	
+	CutMask();
+	CutMask(MatrixXf & overlap, BlockType type, const SynthesisContext & context);
+
+	// Overlap buffer of the current block, filled in by the caller
+	MatrixXf overlap;
+
+	const MatrixXf & compute(MatrixXf & overlap, BlockType type, const SynthesisContext & context);
+
 	MatrixXf getMask();
 };
@@ -18,14 +18,24 @@ using namespace Eigen;
 #define Timer QElapsedTimer
 #define CreateTimer(timer)  QElapsedTimer timer; timer.start()
 
-extern int BlockSize;
-extern int BandSize;
-extern int synthesisWidth;
-extern int cur_x;
-extern int cur_y;
-
 enum BlockType {NONE_BLOCK, VERTICAL, V_BOTHSIDES, HORIZONTAL, L_SHAPED, N_SHAPED };
 
+// Settings of one synthesis, handed to everything working on it so that
+// independent syntheses can run side by side
+struct SynthesisContext
+{
+	int blockSize;
+	int bandSize;
+	int synthesisWidth;
+
+	SynthesisContext(int blockSize = 15, int bandSize = 5, int synthesisWidth = 0)
+	{
+		this->blockSize = blockSize;
+		this->bandSize = bandSize;
+		this->synthesisWidth = synthesisWidth;
+	}
+};
+
 #define EMPTY_PIXEL (FLT_MIN)
 
 #define BLUE (-2)
@@ -0,0 +1,516 @@
+#include "PatchSynthesizer.h"
+
+#include <algorithm>
+#include <omp.h>
+
+namespace Synth
+{
+
+PatchSynthesizer::PatchSynthesizer(int BottomPadding)
+{
+	this->bottomPadding = BottomPadding;
+	this->candidatesPerPixel = 4;
+	this->listener = NULL;
+}
+
+void PatchSynthesizer::setListener(SynthesisListener * listener)
+{
+	this->listener = listener;
+}
+
+void PatchSynthesizer::setCandidatesPerPixel(int k)
+{
+	this->candidatesPerPixel = Max(1, k);
+}
+
+void PatchSynthesizer::init(const MatrixXf & source, int synthWidth, int blockSize, int bandSize)
+{
+	isDone = false;
+
+	cur_x = 0;
+	cur_y = 0;
+
+	// Enforce block and band bounds
+	blockSize = Max(4, Min(blockSize, source.cols() - 1));
+	bandSize = Max(3, Min(bandSize, blockSize / 2));
+	bandSize = Min(bandSize, (blockSize - 1) / 2);	// leave a block interior
+
+	// Settings of this synthesis
+	context = SynthesisContext(blockSize, bandSize, synthWidth);
+
+	blockCount = 0;
+
+	// Prepare matrices
+	this->src = source;
+	this->target = MatrixXf::Constant(source.rows(), synthWidth, EMPTY_PIXEL);
+	this->debug = MatrixXf::Zero(source.rows(), source.cols());
+
+        this->targetAsPos = Vector<Vector<Point> >(source.rows(), Vector<Point>(synthWidth, Point(-1,-1)));
+	
+	// Prepare cut variables
+	int src_width = source.cols();
+	patchSize = context.blockSize - context.bandSize;
+	cut = ceil(src_width / 2.0f) - 1;
+	jump = (floor((context.synthesisWidth - src_width) / (float)patchSize)) * patchSize;
+
+	message("Copying two target pieces..");
+
+	// Index source pixels by value
+	Vector<std::pair<float, Point> > sorted;
+	sorted.reserve(source.rows() * source.cols());
+
+	for(int y = 0; y < source.rows(); y++)
+		for(int x = 0; x < source.cols(); x++)
+			sorted.push_back(std::make_pair(source(y,x), Point(x,y)));
+
+	std::sort(sorted.begin(), sorted.end());
+
+	sortedValues.resize(sorted.size());
+	sortedPixels.resize(sorted.size());
+
+	for(int i = 0; i < (int)sorted.size(); i++)
+	{
+		sortedValues[i] = sorted[i].first;
+		sortedPixels[i] = sorted[i].second;
+	}
+
+	// Copy our two pieces to target
+	for(int y = 0; y < source.rows(); y++)
+	{
+		for(int x = 0; x < source.cols(); x++)
+		{
+			if(x >= cut)
+			{
+				target(y, x + jump) = src(y, x);
+				targetAsPos[y][x + jump] = Point(x,y);
+			}
+			else
+			{
+				target(y, x) = src(y, x);
+				targetAsPos[y][x] = Point(x,y);
+			}
+		}
+	}
+
+	// Scratch of the first thread, copied to the others when needed
+	matchers.assign(1, BlockMatcher());
+	matchers[0].init(src, context.blockSize);
+	seams.assign(1, CutMask());
+}
+
+void PatchSynthesizer::synthesizeAll()
+{
+	message("Starting synthesis.. 0%");
+
+	double startTime = omp_get_wtime();
+
+	int cols = ( context.synthesisWidth - src.cols())	/ patchSize;
+	int rows = ( src.rows() )					/ patchSize;
+
+	int start_x = cut - 1;
+
+	//QString::arg();
+	int count = 0;
+	float total = (float)(cols * rows) + rows + cols;
+
+	// Block positions: top row, then rows below it
+	int numRows = Max(1, rows);
+
+	Vector<int> blockX(cols + 1), blockY(numRows);
+	for(int i = 0; i <= cols; i++)		blockX[i] = start_x + i * patchSize;
+	for(int j = 0; j < numRows; j++)	blockY[j] = (j == 0) ? 0 : (context.blockSize - 1) + (j - 1) * patchSize;
+
+	// One matcher and seam solver per thread, a batch running syntheses
+	// side by side already uses all of them
+	int threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+	BlockMatcher prototype = matchers[0];
+	matchers.resize(threads, prototype);
+	seams.resize(threads);
+
+	// A block overlaps only its left, top-left, top and top-right neighbours,
+	// so with wave = column + 2 * row all of a block's inputs are in earlier
+	// waves and blocks of one wave never overlap. The result is the same as
+	// synthesizing in raster order.
+	int waves = cols + 2 * (numRows - 1) + 1;
+
+	for(int t = 0; t < waves; t++)
+	{
+		int first = Max(0, (t - cols + 1) / 2);
+		int last = Min(numRows - 1, t / 2);
+
+		#pragma omp parallel for schedule(dynamic)
+		for(int j = first; j <= last; j++)
+		{
+			int thread = omp_get_thread_num();
+			synthesizeBlock(blockX[t - 2 * j], blockY[j], matchers[thread], seams[thread]);
+		}
+
+		count += last - first + 1;
+
+		// Columns touched by this wave
+		if(listener)
+		{
+			int left = blockX[t - 2 * last] - (context.bandSize - 1);
+			int right = blockX[t - 2 * first] - context.bandSize + context.blockSize;
+
+			listener->progress(count / total, left, right);
+		}
+	}
+
+	// Matching throughput
+	int mapCount = 0;
+	for(int i = 0; i < (int)matchers.size(); i++) mapCount += matchers[i].mapCount;
+
+	double seconds = Max(0.001, omp_get_wtime() - startTime);
+	int blocks = blockCount;
+
+	char text[128];
+	sprintf(text, "Synthesized %d blocks (%d blocks/sec)", blocks, (int)(blocks / seconds));
+
+	printf("\nSynthesized %d blocks in %d ms (%.1f blocks/sec, %d score maps, %d threads).", 
+		blocks, (int)(seconds * 1000), blocks / seconds, mapCount, threads);
+	message(text);
+
+	isDone = true;
+}
+
+void PatchSynthesizer::message(const char * text)
+{
+	if(listener) listener->message(text);
+}
+
+void PatchSynthesizer::synthesizeNext()
+{
+	synthesizeBlock(cur_x, cur_y, matchers[0], seams[0]);
+}
+
+void PatchSynthesizer::synthesizeBlock(int u, int v, BlockMatcher & matcher, CutMask & cut)
+{
+	// Bounds checks
+	if(u + patchSize > target.cols() || v + patchSize > target.rows())	return;
+
+	BlockType foundType = getBlockType(u, v);
+
+	ReducedSet set = getMatchingBlocks(foundType, u, v);
+
+	if(set.size())
+	{
+		Block best_block = getBestBlock( set, u, v, matcher );
+
+                best_block.paste(u, v, &target, &targetAsPos, &cut);
+
+		#pragma omp atomic
+		blockCount++;
+	}
+}
+
+Block PatchSynthesizer::getBestBlock(ReducedSet & set, int u, int v, BlockMatcher & matcher)
+{
+	Block candidate;
+	BlockType type = set.begin()->second.type;
+
+	float Si, Smin = FLT_MAX;
+
+	WeightMatrix weight(type, context);
+	MatrixXf target_block;
+
+	// Prepare target block
+	if(type == VERTICAL || type == V_BOTHSIDES)
+	{
+		target_block = target.block(v, u - (context.bandSize - 1), context.blockSize, context.blockSize);
+	}
+	else if(type == L_SHAPED || type == N_SHAPED)
+	{
+		target_block = target.block(v - (context.bandSize - 1), u - (context.bandSize - 1), context.blockSize, context.blockSize);
+	}
+
+	int bx = 0;
+	int by = 0;
+
+	matcher.setBlock(type, weight.m, target_block);
+
+	// Large sets: score every position at once, then settle near-ties directly
+	if(matcher.isMapCheaper(set.size()))
+	{
+		const MatrixXf & scores = matcher.scoreMap();
+
+		float approxMin = FLT_MAX;
+		for (ReducedSet::iterator i = set.begin(); i != set.end(); ++i)
+			approxMin = Min(approxMin, scores(i->second.p.y, i->second.p.x));
+
+		float threshold = approxMin + matcher.tolerance(approxMin);
+
+		for (ReducedSet::iterator i = set.begin(); i != set.end(); ++i) {
+			bx = i->second.p.x;
+			by = i->second.p.y;
+
+			if(scores(by, bx) > threshold) continue;
+
+			Si = matcher.score(bx, by);
+
+			if(Si < Smin){
+				Smin = Si;
+				candidate = i->second;
+
+				if(Smin == 0) break;
+			}
+		}
+
+		return candidate;
+	}
+
+	// Check all blocks in our reduced set
+	for (ReducedSet::iterator i = set.begin(); i != set.end(); ++i) {
+		bx = i->second.p.x;
+		by = i->second.p.y;
+
+		Si = matcher.score(bx, by);
+
+		/* Location matters?
+		int half_src = src.cols() / 2;
+		float x_penalty = 1 + abs(bx - half_src) + abs(Bi.x() - u);
+		float y_penalty = 1 + abs(by - v);
+	
+		float locationPenalty = (float)(x_penalty * y_penalty);
+		*/
+
+		Si = Si;// * locationPenalty;
+
+		if(Si < Smin){
+			Smin = Si;
+			candidate = i->second;
+
+			if(Smin == 0) break;
+		}
+	}
+
+	return candidate;
+}
+
+ReducedSet PatchSynthesizer::getMatchingBlocks(BlockType type, int u, int v)
+{
+	ReducedSet set;
+
+        CheckList list;
+
+	switch(type)
+	{
+		case VERTICAL:
+			for(int j = 0; j < context.blockSize; j++)
+				addBlocks(Point(u, v + j), context.bandSize - 1, j, VERTICAL, set, list);
+			break;
+
+		case V_BOTHSIDES:
+			{
+				int side = (context.blockSize - 2 * context.bandSize) + 1;
+
+				for(int j = 0; j < context.blockSize; j++)
+				{
+					addBlocks(Point(u, v + j), context.bandSize - 1, j, V_BOTHSIDES, set, list);
+					list.clear();
+					addBlocks(Point(u + side, v + j), context.blockSize - context.bandSize, j, V_BOTHSIDES, set, list);
+				}
+			}
+			break;
+
+		case L_SHAPED:
+			for(int j = 0; j < (context.blockSize - context.bandSize) + 1; j++)
+			{
+				addBlocks(Point(u, v + j), context.bandSize - 1, (context.bandSize - 1) + j, L_SHAPED, set, list); // Y-Direction
+				addBlocks(Point(u + j, v), (context.bandSize - 1) + j, context.bandSize - 1, L_SHAPED, set, list); // X-Direction
+			}
+			break;
+
+		case N_SHAPED:
+			{
+				int side = (context.blockSize - 2 * context.bandSize) + 1;
+
+				// Y-Direction
+				for(int j = 0; j < (context.blockSize - context.bandSize) + 1; j++)
+				{
+					addBlocks(Point(u, v + j), context.bandSize - 1, (context.bandSize - 1) + j, N_SHAPED, set, list);
+					addBlocks(Point(u + side, v + j), context.blockSize - context.bandSize, (context.bandSize - 1) + j, N_SHAPED, set, list);
+				}
+
+				// X-Direction
+				for(int j = 0; j < side; j++)
+					addBlocks(Point(u, v + j), context.bandSize - 1, (context.bandSize - 1) + j, N_SHAPED, set, list);
+			}
+			break;
+
+                case NONE_BLOCK:
+                case HORIZONTAL:
+                        break;
+	}
+
+        list.size();
+
+	return set;
+}
+
+void PatchSynthesizer::addBlocks(Point at, int deltaX, int deltaY, 
+							BlockType type, 
+							ReducedSet & set,
+							CheckList & list)
+{
+	float color = target(at.y, at.x);
+
+	Point curr_point, relative;
+
+	int begin, end;
+	nearestPixels(color, begin, end);
+
+	//if(!list[color])
+	{
+		// Check all possible blocks matching current color
+                for(int i = begin; i < end; i++){
+			curr_point = sortedPixels[i];
+			relative = Point(curr_point.x - deltaX, curr_point.y - deltaY);
+
+			if(isValidPatch(relative))
+			{
+				if( set.find(relative) == set.end() )
+				{
+					set[relative] = Block(relative, &src, type, &context);
+					//list[color] = true;
+				}
+			}
+		}
+	}
+
+	// If nothing is there, check everything at that pixel
+        if((int)set.size() < 1)
+	{
+                for(int i = 0; i < (int)sortedPixels.size(); i++)
+		{
+			curr_point = sortedPixels[i];
+			relative = Point(curr_point.x - deltaX, curr_point.y - deltaY);
+
+			if(isValidPatch(relative))
+			{
+				if( set.find(relative) == set.end() )
+				{
+					set[relative] = Block(relative, &src, type, &context);
+					//list[color] = true;
+				}
+			}
+		}
+	}
+
+        list.size();
+}
+
+void PatchSynthesizer::nearestPixels(float color, int & begin, int & end)
+{
+	// All exact matches
+	begin = std::lower_bound(sortedValues.begin(), sortedValues.end(), color) - sortedValues.begin();
+	end = std::upper_bound(sortedValues.begin() + begin, sortedValues.end(), color) - sortedValues.begin();
+
+	// Grow towards the closer value until we have enough
+	while(end - begin < candidatesPerPixel)
+	{
+		bool hasLower = begin > 0;
+		bool hasUpper = end < (int)sortedValues.size();
+
+		if(!hasLower && !hasUpper) break;
+
+		if(hasLower && (!hasUpper || color - sortedValues[begin - 1] <= sortedValues[end] - color))
+			begin--;
+		else
+			end++;
+	}
+}
+
+BlockType PatchSynthesizer::getBlockType(int u, int v)
+{
+	if(v < context.bandSize)
+	{
+                Point p = pixel(u + patchSize, v);
+                if( empty(p) )
+			return VERTICAL;
+		else
+			return V_BOTHSIDES;
+	}
+	else if(v + patchSize < src.rows())
+	{
+                Point p = pixel(u + patchSize, v + patchSize);
+                if( empty(p) )
+			return L_SHAPED;
+		else
+			return N_SHAPED;
+	}
+
+	return NONE_BLOCK;
+}
+
+void PatchSynthesizer::crop()
+{
+	int widthCrop = target.cols();
+	int heightCrop = this->target.rows() - bottomPadding;
+ 	
+	while(target(0, --widthCrop) == EMPTY_PIXEL && widthCrop >= 0); 
+
+	// Convert index to width
+	widthCrop += 1;
+
+	// Rows no block reached (no bottom padding) continue the patch above, or the one on the left
+	for(int y = 0; y < heightCrop; y++)
+	{
+		for(int x = 0; x < widthCrop; x++)
+		{
+			Point & p = targetAsPos[y][x];
+			if(p.x >= 0 && p.y >= 0) continue;
+
+			if(y > 0)
+			{
+				const Point & a = targetAsPos[y-1][x];
+				p = Point(a.x, Min(a.y + 1, (int)src.rows() - 1));
+			}
+			else
+			{
+				const Point & l = targetAsPos[y][x-1];
+				p = Point(Min(l.x + 1, (int)src.cols() - 1), l.y);
+			}
+
+			target(y, x) = src(p.y, p.x);
+		}
+	}
+
+	// As pixel values
+	MatrixXf temp = target.block(0, 0, heightCrop, widthCrop); 
+	target = temp;
+
+	// As positions
+        Vector<Vector<Point> > tempAsPos = Vector<Vector<Point> >(heightCrop, Vector<Point>(widthCrop, Point(-1,-1)));
+	for(int x = 0; x < widthCrop; x++)
+	{
+		for(int y = 0; y < heightCrop; y++)
+		{
+			tempAsPos[y][x] = Point(targetAsPos[y][x].x, targetAsPos[y][x].y % heightCrop);
+		}
+	}
+	targetAsPos = tempAsPos;
+}
+
+bool PatchSynthesizer::isValidPatch(Point & p)
+{
+	return p.x >= 0 && p.x < (src.cols() - context.blockSize) 
+		   && p.y >= 0 && p.y < (src.rows() - context.blockSize);
+}
+
+const MatrixXf & PatchSynthesizer::preview()
+{
+	return target;
+}
+
+MatrixXf PatchSynthesizer::result()
+{
+	return target;
+}
+
+Vector<Vector<Point> > PatchSynthesizer::resultAsPos()
+{
+	return targetAsPos;
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Globals.h"
+#include "Block.h"
+#include "WeightMatrix.h"
+#include "BlockMatcher.h"
+
+namespace Synth
+{
+	typedef StdMap<Point, Block> ReducedSet;
+
+	// Receives progress of a synthesis, called from the synthesizing thread
+	class SynthesisListener
+	{
+		public:
+			virtual ~SynthesisListener() {}
+
+			virtual void message(const char * text) = 0;
+
+			// 'done' in [0,1], target columns [left, right] changed since the last call.
+			// Called between waves, no block is being written meanwhile
+			virtual void progress(float done, int left, int right) = 0;
+	};
+
+	// Patch-based synthesis, plain C++ with no Qt objects so it can run
+	// headless. Synthesizer wraps it into a thread for the UI.
+	class PatchSynthesizer
+	{
+		private:
+			SynthesisContext context;
+
+			MatrixXf src;
+			MatrixXf target;
+			Vector<Vector<Point> > targetAsPos;
+
+			MatrixXf debug;
+
+			// Source pixels sorted by value, for candidate lookups
+			Vector<float> sortedValues;
+			Vector<Point> sortedPixels;
+			int candidatesPerPixel;
+
+			void nearestPixels(float color, int & begin, int & end);
+
+			// Per thread scratch
+			Vector<BlockMatcher> matchers;
+			Vector<CutMask> seams;
+
+			void synthesizeBlock(int u, int v, BlockMatcher & matcher, CutMask & cut);
+			int blockCount;
+
+			SynthesisListener * listener;
+			void message(const char * text);
+
+			int cut;
+			int jump;
+			int patchSize;
+			int bottomPadding;
+
+			int cur_x;
+			int cur_y;
+
+		public:
+			PatchSynthesizer(int BottomPadding = 0);
+
+			void init(const MatrixXf & source, int synthWidth, int blockSize, int bandSize);
+
+			// Accuracy / speed knob: source pixels closest in value to each
+			// overlap pixel that seed candidate blocks (exact matches always do)
+			void setCandidatesPerPixel(int k);
+			void setListener(SynthesisListener * listener);
+
+			void synthesizeNext();
+
+			void synthesizeAll();
+
+			// Block operations
+			BlockType getBlockType(int u, int v);
+			ReducedSet getMatchingBlocks(BlockType, int u, int v);
+			Block getBestBlock(ReducedSet & set, int u, int v, BlockMatcher & matcher);
+			void addBlocks(Point at, int deltaX, int deltaY, BlockType type, ReducedSet & set, CheckList & list);
+
+			// Pixel helper functions
+			Point pixel(int x, int y) { return Point(x,y) ;}
+			inline bool empty(Point & p)	{return target(p.y, p.x) == EMPTY_PIXEL;}
+			bool isValidPatch(Point & p);
+
+			bool isDone;
+
+			void crop();
+
+			// Current target, changing while synthesizing: read it from
+			// SynthesisListener::progress or once done
+			const MatrixXf & preview();
+
+			MatrixXf result();
+			Vector<Vector<Point> > resultAsPos();
+	};
+}
@@ -0,0 +1,210 @@
+#include "PyramidSynthesizer.h"
+
+namespace Synth
+{
+
+PyramidSynthesizer::PyramidSynthesizer(int levels, int radius, int iterations)
+{
+	this->levels = Max(0, levels);
+	this->radius = Max(1, radius);
+	this->iterations = Max(1, iterations);
+}
+
+Vector<Vector<Point> > PyramidSynthesizer::synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band)
+{
+	// Source pyramid, finest first, keep a couple of blocks per side and
+	// stop once a block can't hold its two bands and an interior
+	Vector<MatrixXf> pyramid(1, src);
+
+	while((int)pyramid.size() <= levels)
+	{
+		const MatrixXf & m = pyramid.back();
+		int coarseBlock = block >> pyramid.size();
+		int minSide = 2 * Max(4, coarseBlock);
+
+		if(coarseBlock < 2 * Max(3, band >> pyramid.size()) + 1) break;
+		if(m.rows() / 2 < minSide || m.cols() / 2 < minSide) break;
+
+		pyramid.push_back(downsample(m));
+	}
+
+	int top = pyramid.size() - 1;
+
+	int coarseBlock = Max(4, block >> top);
+	int coarseBand = Min(Max(3, band >> top), (coarseBlock - 1) / 2);
+
+	// Patch-based synthesis on the coarsest level
+	PatchSynthesizer s(pad >> top);
+	s.init(pyramid[top], width >> top, coarseBlock, coarseBand);
+	s.synthesizeAll();
+	s.crop();
+
+	Vector<Vector<Point> > pos = s.resultAsPos();
+
+	// Refine towards the full resolution
+	for(int l = top - 1; l >= 0; l--)
+	{
+		const MatrixXf & fine = pyramid[l];
+
+		pos = upsample(pos, fine, fine.rows() - (pad >> l), 2 * pos.front().size());
+
+		for(int i = 0; i < iterations; i++)
+			refine(pos, fine);
+	}
+
+	// Same format as PatchSynthesizer::crop
+	int rows = pos.size();
+	int cols = pos.front().size();
+
+	output = MatrixXf(rows, cols);
+
+	for(int y = 0; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			output(y,x) = src(pos[y][x].y, pos[y][x].x);
+			pos[y][x].y %= rows;
+		}
+	}
+
+	return pos;
+}
+
+MatrixXf PyramidSynthesizer::downsample(const MatrixXf & m)
+{
+	MatrixXf d(m.rows() / 2, m.cols() / 2);
+
+	for(int y = 0; y < d.rows(); y++)
+		for(int x = 0; x < d.cols(); x++)
+			d(y,x) = 0.25f * (m(2*y, 2*x) + m(2*y, 2*x+1) + m(2*y+1, 2*x) + m(2*y+1, 2*x+1));
+
+	return d;
+}
+
+Vector<Vector<Point> > PyramidSynthesizer::upsample(const Vector<Vector<Point> > & coarse, const MatrixXf & src, int rows, int cols)
+{
+	Vector<Vector<Point> > pos(rows, Vector<Point>(cols));
+
+	int coarseRows = coarse.size();
+	int coarseCols = coarse.front().size();
+
+	for(int y = 0; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			const Point & c = coarse[Min(y / 2, coarseRows - 1)][Min(x / 2, coarseCols - 1)];
+
+			pos[y][x] = Point(Min(2 * c.x + x % 2, (int)src.cols() - 1), Min(2 * c.y + y % 2, (int)src.rows() - 1));
+		}
+	}
+
+	return pos;
+}
+
+void PyramidSynthesizer::refine(Vector<Vector<Point> > & pos, const MatrixXf & src)
+{
+	int rows = pos.size();
+	int cols = pos.front().size();
+
+	// Guidance is the current result
+	MatrixXf guide(rows, cols);
+
+	for(int y = 0; y < rows; y++)
+		for(int x = 0; x < cols; x++)
+			guide(y,x) = src(pos[y][x].y, pos[y][x].x);
+
+	Vector<Vector<Point> > refined = pos;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int y = 0; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			// Inside a coherent patch nothing would change
+			if(!isSeam(pos, x, y)) continue;
+
+			Point best = pos[y][x];
+			float minDistance = distance(src, guide, best, x, y);
+
+			// Continue the patches of the neighbours
+			for(int dy = -radius; dy <= radius; dy++)
+			{
+				for(int dx = -radius; dx <= radius; dx++)
+				{
+					int nx = x + dx, ny = y + dy;
+					if(nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+
+					Point q(pos[ny][nx].x - dx, pos[ny][nx].y - dy);
+
+					if(q.x < radius || q.y < radius || q.x >= src.cols() - radius || q.y >= src.rows() - radius)
+						continue;
+
+					float d = distance(src, guide, q, x, y);
+
+					if(d < minDistance)
+					{
+						minDistance = d;
+						best = q;
+					}
+				}
+			}
+
+			refined[y][x] = best;
+		}
+	}
+
+	pos = refined;
+}
+
+bool PyramidSynthesizer::isSeam(const Vector<Vector<Point> > & pos, int x, int y)
+{
+	int rows = pos.size();
+	int cols = pos.front().size();
+
+	const Point & p = pos[y][x];
+
+	for(int dy = -radius; dy <= radius; dy++)
+	{
+		for(int dx = -radius; dx <= radius; dx++)
+		{
+			int nx = x + dx, ny = y + dy;
+			if(nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+
+			const Point & n = pos[ny][nx];
+
+			if(n.x - p.x != dx || n.y - p.y != dy)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+float PyramidSynthesizer::distance(const MatrixXf & src, const MatrixXf & guide, Point q, int x, int y)
+{
+	float sum = 0;
+
+	for(int dy = -radius; dy <= radius; dy++)
+	{
+		for(int dx = -radius; dx <= radius; dx++)
+		{
+			int tx = x + dx, ty = y + dy;
+			int sx = q.x + dx, sy = q.y + dy;
+
+			if(tx < 0 || ty < 0 || tx >= guide.cols() || ty >= guide.rows()) continue;
+			if(sx < 0 || sy < 0 || sx >= src.cols() || sy >= src.rows()) continue;
+
+			float diff = src(sy, sx) - guide(ty, tx);
+			sum += diff * diff;
+		}
+	}
+
+	return sum;
+}
+
+MatrixXf PyramidSynthesizer::result()
+{
+	return output;
+}
+
+}
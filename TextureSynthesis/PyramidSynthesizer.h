@@ -0,0 +1,36 @@
+#pragma once
+
+#include "PatchSynthesizer.h"
+
+namespace Synth
+{
+	// Coarse-to-fine patch synthesis. Patch search only runs on a downsampled
+	// source; each finer level starts from the upsampled positions and only
+	// re-matches pixels near patch seams, against coherent candidates taken
+	// from their neighbours.
+	class PyramidSynthesizer
+	{
+		private:
+			int levels;
+			int radius;
+			int iterations;
+
+			MatrixXf output;
+
+			static MatrixXf downsample(const MatrixXf & m);
+
+			Vector<Vector<Point> > upsample(const Vector<Vector<Point> > & coarse, const MatrixXf & src, int rows, int cols);
+			void refine(Vector<Vector<Point> > & pos, const MatrixXf & src);
+
+			bool isSeam(const Vector<Vector<Point> > & pos, int x, int y);
+			float distance(const MatrixXf & src, const MatrixXf & guide, Point q, int x, int y);
+
+		public:
+			// 'levels' coarser levels at most, 'radius' of the matched neighbourhood
+			PyramidSynthesizer(int levels = 2, int radius = 2, int iterations = 2);
+
+			Vector<Vector<Point> > synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band);
+
+			MatrixXf result();
+	};
+}
@@ -0,0 +1,77 @@
+// Headless check of the synthesis methods, no Qt needed:
+//
+//   g++ -std=gnu++98 -fopenmp -I. -IEigen -ITextureSynthesis -IGraphicsLibrary -IUtility TextureSynthesis/SynthesisCheck.cpp
+//       TextureSynthesis/{Block,BlockMatcher,CoherenceSynthesizer,CutMask,PatchSynthesizer,
+//       PyramidSynthesizer,SynthesisRunner,Tiler,WeightMatrix}.cpp -o synthesisCheck
+//
+// Runs every method with the widget's defaults (block 14, band 20% of the
+// width, half the rows as bottom padding), without bottom padding, and with
+// the smallest blocks the widget allows. Exits non-zero on failure.
+
+#include "SynthesisRunner.h"
+
+#include <math.h>
+
+using namespace Synth;
+
+static const char * methodName[] = { "Patch-Based", "Multi-resolution", "Coherence", "Tiling" };
+
+static bool check(const MatrixXf & src, int pad, int width, int block, int band, SynthesisMethod method)
+{
+	SynthesisJob job(src, pad, width, block, band, method);
+
+	synthesize(job);
+
+	bool isValid = !job.resultAsPos.empty() && !job.resultAsPos.front().empty();
+
+	for(int y = 0; isValid && y < (int)job.resultAsPos.size(); y++)
+	{
+		for(int x = 0; x < (int)job.resultAsPos[y].size(); x++)
+		{
+			const Point & p = job.resultAsPos[y][x];
+
+			if(p.x < 0 || p.y < 0 || p.x >= src.cols() || p.y >= src.rows())
+				isValid = false;
+		}
+	}
+
+	printf("\n%-16s pad %3d block %3d band %3d: %s", methodName[method], pad, block, band, isValid ? "ok" : "FAILED");
+
+	return isValid;
+}
+
+int main()
+{
+	// Grid heights of a ridged surface
+	int rows = 40, cols = 60;
+
+	MatrixXf src(rows, cols);
+
+	for(int y = 0; y < rows; y++)
+		for(int x = 0; x < cols; x++)
+			src(y,x) = sin(x * 0.4f) + cos(y * 0.3f) + 0.2f * sin(x * y * 0.05f);
+
+	int width = 3 * cols;
+	int autoBand = Max(3, cols * 0.20);
+
+	int failed = 0;
+
+	for(int m = PATCH_SYNTHESIS; m <= TILING; m++)
+	{
+		failed += !check(src, rows / 2, width, 14, autoBand, (SynthesisMethod)m);
+
+		// SynthesisJob's default, blocks may not reach the bottom rows
+		failed += !check(src, 0, width, 14, autoBand, (SynthesisMethod)m);
+	}
+
+	// Smallest blocks and widest bands
+	for(int block = 4; block <= 15; block++)
+	{
+		failed += !check(src, rows / 2, width, block, block / 2, PATCH_SYNTHESIS);
+		failed += !check(src, rows / 2, width, block, block / 2, PYRAMID_SYNTHESIS);
+	}
+
+	printf("\n\n%d failed.\n", failed);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#include "SynthesisRunner.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace Synth
+{
+
+void synthesize(SynthesisJob & job)
+{
+	switch(job.method)
+	{
+		case PATCH_SYNTHESIS:
+			{
+				PatchSynthesizer synth(job.pad);
+				synth.setCandidatesPerPixel(job.candidates);
+				synth.init(job.src, job.width, job.block, job.band);
+				synth.synthesizeAll();
+				synth.crop();
+
+				job.result = synth.result();
+				job.resultAsPos = synth.resultAsPos();
+			}
+			break;
+
+		case PYRAMID_SYNTHESIS:
+			{
+				PyramidSynthesizer pyramid(job.levels);
+				job.resultAsPos = pyramid.synthesizeAsPos(job.src, job.pad, job.width, job.block, job.band);
+				job.result = pyramid.result();
+			}
+			break;
+
+		case COHERENCE_SYNTHESIS:
+			{
+				CoherenceSynthesizer coherence(2, job.iterations);
+				job.resultAsPos = coherence.synthesizeAsPos(job.src, job.pad, job.width, job.block);
+				job.result = coherence.result();
+			}
+			break;
+
+		case TILING:
+			{
+				int tileCount = ceil((float)job.width / job.src.cols());
+
+				MatrixXi pos = Tiler(job.src, SynthesisContext(job.src.cols(), job.band, job.width), tileCount).tileAsPos();
+
+				// Positions are column-major indices + 1 into the source
+				int rows = job.src.rows();
+
+				job.resultAsPos = Vector<Vector<Point> >(pos.rows(), Vector<Point>(pos.cols()));
+				for(int y = 0; y < pos.rows(); y++)
+				{
+					for(int x = 0; x < pos.cols(); x++)
+					{
+						int i = pos(y,x) - 1;
+						job.resultAsPos[y][x] = Point(i / rows, i % rows);
+					}
+				}
+
+				job.result = FromPositionMatrix(job.src, pos);
+			}
+			break;
+	}
+}
+
+SynthesisRunner::SynthesisRunner(int threads)
+{
+	this->threadCount = (threads > 0) ? threads : omp_get_max_threads();
+	this->seconds = 0;
+	this->steals = 0;
+}
+
+void SynthesisRunner::run(Vector<SynthesisJob> & jobs)
+{
+	double startTime = omp_get_wtime();
+	steals = 0;
+
+	// Largest first by output size, dealt round robin
+	Vector<std::pair<int, int> > order;
+	for(int i = 0; i < (int)jobs.size(); i++)
+		order.push_back(std::make_pair(-(int)jobs[i].src.rows() * Max(jobs[i].width, (int)jobs[i].src.cols()), i));
+
+	std::sort(order.begin(), order.end());
+
+	queues.assign(threadCount, std::deque<int>());
+	locks.resize(threadCount);
+
+	for(int t = 0; t < threadCount; t++)
+		omp_init_lock(&locks[t]);
+
+	for(int i = 0; i < (int)order.size(); i++)
+		queues[i % threadCount].push_back(order[i].second);
+
+	#pragma omp parallel num_threads(threadCount)
+	{
+		int thread = omp_get_thread_num();
+		int job;
+
+		while(nextJob(thread, job))
+		{
+			double jobStart = omp_get_wtime();
+
+			synthesize(jobs[job]);
+
+			jobs[job].seconds = omp_get_wtime() - jobStart;
+			jobs[job].thread = thread;
+		}
+	}
+
+	for(int t = 0; t < threadCount; t++)
+		omp_destroy_lock(&locks[t]);
+
+	seconds = omp_get_wtime() - startTime;
+
+	double busy = 0;
+	for(int i = 0; i < (int)jobs.size(); i++) busy += jobs[i].seconds;
+
+	printf("\nSynthesized %d jobs in %d ms on %d threads (%d ms of work, %d steals).",
+		(int)jobs.size(), (int)(seconds * 1000), threadCount, (int)(busy * 1000), steals);
+}
+
+bool SynthesisRunner::nextJob(int thread, int & job)
+{
+	// Own queue from the front
+	omp_set_lock(&locks[thread]);
+	bool found = !queues[thread].empty();
+	if(found)
+	{
+		job = queues[thread].front();
+		queues[thread].pop_front();
+	}
+	omp_unset_lock(&locks[thread]);
+
+	if(found) return true;
+
+	// Others from the back, their smallest jobs
+	for(int i = 1; i < threadCount && !found; i++)
+	{
+		int victim = (thread + i) % threadCount;
+
+		omp_set_lock(&locks[victim]);
+		if(!queues[victim].empty())
+		{
+			job = queues[victim].back();
+			queues[victim].pop_back();
+			found = true;
+		}
+		omp_unset_lock(&locks[victim]);
+	}
+
+	if(found)
+	{
+		#pragma omp atomic
+		steals++;
+	}
+
+	return found;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <deque>
+#include <omp.h>
+
+#include "PatchSynthesizer.h"
+#include "PyramidSynthesizer.h"
+#include "CoherenceSynthesizer.h"
+#include "Tiler.h"
+
+namespace Synth
+{
+	enum SynthesisMethod { PATCH_SYNTHESIS, PYRAMID_SYNTHESIS, COHERENCE_SYNTHESIS, TILING };
+
+	// One independent synthesis: grid heights in, position map out
+	struct SynthesisJob
+	{
+		MatrixXf src;
+		int pad, width, block, band;
+		SynthesisMethod method;
+
+		// Source pixels seeding candidate blocks (patch-based), coarser
+		// levels (pyramid) and search iterations (coherence)
+		int candidates, levels, iterations;
+
+		Vector<Vector<Point> > resultAsPos;
+		MatrixXf result;
+
+		// Filled in when run, time spent and thread that ran it
+		double seconds;
+		int thread;
+
+		SynthesisJob(const MatrixXf & src = MatrixXf(), int pad = 0, int width = 0, int block = 15, int band = 5,
+			SynthesisMethod method = PATCH_SYNTHESIS)
+		{
+			this->src = src;
+			this->pad = pad;
+			this->width = width;
+			this->block = block;
+			this->band = band;
+			this->method = method;
+			this->candidates = 4;
+			this->levels = 2;
+			this->iterations = 2;
+
+			this->seconds = 0;
+			this->thread = 0;
+		}
+	};
+
+	// Runs one job on the calling thread, no Qt objects involved
+	void synthesize(SynthesisJob & job);
+
+	// Runs many jobs on a pool of OpenMP threads. Jobs are dealt out largest
+	// first, a thread that runs out of its own jobs steals from the back of
+	// another thread's queue.
+	class SynthesisRunner
+	{
+		private:
+			int threadCount;
+
+			Vector<std::deque<int> > queues;
+			Vector<omp_lock_t> locks;
+
+			bool nextJob(int thread, int & job);
+
+		public:
+			// All OpenMP threads when 'threads' is zero
+			SynthesisRunner(int threads = 0);
+
+			void run(Vector<SynthesisJob> & jobs);
+
+			// Of the last run
+			double seconds;
+			int steals;
+	};
+}
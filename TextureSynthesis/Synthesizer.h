@@ -2,35 +2,31 @@
 
 #include <QThread>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
 
-#include "Globals.h"
-#include "Block.h"
-#include "WeightMatrix.h"
+#include "PatchSynthesizer.h"
+
+// Minimum time between progress messages and previews (ms)
+#define PROGRESS_INTERVAL 100
 
 namespace Synth
 {
-	typedef StdMap<Point, Block> ReducedSet;
-
-	class Synthesizer : public QThread
+	// Runs a PatchSynthesizer on its own thread, progress as Qt signals
+	class Synthesizer : public QThread, public SynthesisListener
 	{
 		Q_OBJECT
 
 		private:
-			MatrixXf src;
-			MatrixXf target;
-			Vector<Vector<Point> > targetAsPos;
-
-			MatrixXf debug;
-
-			StdMap<float, Vector<Point> > positions;
+			PatchSynthesizer synth;
 
-			int cut;
-			int jump;
-			int patchSize;
-			int bottomPadding;
-
-			int cur_x;
-			int cur_y;
+			// Progress: completion and columns changed since the last snapshot
+			QMutex progressMutex;
+			MatrixXf published;	// target as of the last wave
+			QWaitCondition doneCondition;
+			QElapsedTimer printTimer;
+			int dirtyLeft, dirtyRight;
+			bool isFinished;
 
 		protected:
 			void run();
@@ -39,28 +35,26 @@ namespace Synth
 			Synthesizer(int BottomPadding = 0);
 
 			void init(const MatrixXf & source, int synthWidth, int blockSize, int bandSize);
-			void synthesizeNext();
 
-			void synthesizeAll();
+			void setCandidatesPerPixel(int k);
 
-			// Block operations
-			BlockType getBlockType();
-			ReducedSet getMatchingBlocks(BlockType);
-			Block getBestBlock(ReducedSet & set);
-			void addBlocks(Point at, int deltaX, int deltaY, BlockType type, ReducedSet & set, CheckList & list);
+			void synthesizeAll();
 
-			// Pixel helper functions
-			Point pixel(int x, int y) { return Point(x,y) ;}
-			inline bool empty(Point & p)	{return target(p.y, p.x) == EMPTY_PIXEL;}
-			bool isValidPatch(Point & p);
+			// Blocks until done or 'time' ms passed, returns true when done
+			bool waitUntilDone(unsigned long time);
 
-			bool isDone;
+			// Copies changed parts of the target into 'preview', false if nothing changed
+			bool snapshot(MatrixXf & preview);
 
 			void crop();
 
 			MatrixXf result();
 			Vector<Vector<Point> > resultAsPos();
 
+			// SynthesisListener
+			void message(const char * text);
+			void progress(float done, int left, int right);
+
 		signals:
 			void print(QString);
 			void view(MatrixXf m);
@@ -36,10 +36,13 @@ void TextureSynthesizer::run()
 
 	s->start();
 
-	// update progress
-	while(!s->isDone)
+	// update progress, at most every PROGRESS_INTERVAL ms and only when changed
+	MatrixXf preview;
+
+	while(!s->waitUntilDone(PROGRESS_INTERVAL))
 	{
-		update(QPixmap::fromImage(Matrixf::imageFromMatrix(s->result())));
+		if(s->snapshot(preview))
+			update(QPixmap::fromImage(Matrixf::imageFromMatrix(preview)));
 	}
 
 	// Crop unused parts
@@ -51,56 +54,62 @@ void TextureSynthesizer::run()
 	
 	// save it as our output
 	this->output = s->result();
+	this->outputPos = s->resultAsPos();
 }
 
-Vector<Vector<Point> > TextureSynthesizer::synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band)
+Vector<Vector<Point> > TextureSynthesizer::synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band, int candidates)
 {
-	this->input = src;
+	SynthesisJob job(src, pad, width, block, band, PATCH_SYNTHESIS);
+	job.candidates = candidates;
 
-	s = new Synthesizer(pad);
-	s->init(src, width, block, band);
+	return synthesizeJob(job);
+}
 
-	s->synthesizeAll();
+void TextureSynthesizer::synthesizeBatch(Vector<SynthesisJob> & jobs)
+{
+	SynthesisRunner().run(jobs);
+}
 
-	s->crop();
+Vector<Vector<Point> > TextureSynthesizer::outputAsPos()
+{
+	return outputPos;
+}
 
-	this->output = s->result();
+Vector<Vector<Point> > TextureSynthesizer::pyramidAsPos(const MatrixXf & src, int pad, int width, int block, int band, int levels)
+{
+	SynthesisJob job(src, pad, width, block, band, PYRAMID_SYNTHESIS);
+	job.levels = levels;
 
-	return s->resultAsPos();
+	return synthesizeJob(job);
 }
 
-Vector<Vector<Point> > TextureSynthesizer::outputAsPos()
+Vector<Vector<Point> > TextureSynthesizer::coherenceAsPos(const MatrixXf & src, int pad, int width, int block, int iterations)
 {
-	return s->resultAsPos();
+	SynthesisJob job(src, pad, width, block, 0, COHERENCE_SYNTHESIS);
+	job.iterations = iterations;
+
+	return synthesizeJob(job);
 }
 
 Vector<Vector<Point> > TextureSynthesizer::tileAsPos(const MatrixXf & src, int width, int band)
 {
-	this->input = src;
 	tileCount = ceil((float)width / src.cols());
 
-	MatrixXi pos = Tiler(src, band, tileCount).tileAsPos(); // synthesize
-	MatrixXi indices = NumberedMatrix(src.rows(), src.cols());
-	
-	// Create an integer map : 1->(0,0) ... etc
-	StdMap< int, Point > indexMap;
-	for(int y = 0; y < indices.rows(); y++)
-	{
-		for(int x = 0; x < indices.cols(); x++)
-			indexMap[indices.coeffRef(y,x)] = Point(x,y);
-	}
+	SynthesisJob job(src, 0, width, src.cols(), band, TILING);
 
-	// Convert to our 2D grid of Points format
-        Vector<Vector<Point> > tempAsPos = Vector<Vector<Point> >(pos.rows(), Vector<Point>(pos.cols(), Point(-1,-1)));
-	for(int y = 0; y < pos.rows(); y++)
-	{
-		for(int x = 0; x < pos.cols(); x++)
-			tempAsPos[y][x] = indexMap[pos(y,x)];
-	}
+	return synthesizeJob(job);
+}
 
-	this->output = FromPositionMatrix(src, pos);
+Vector<Vector<Point> > TextureSynthesizer::synthesizeJob(SynthesisJob & job)
+{
+	this->input = job.src;
 
-	return tempAsPos;
+	synthesize(job);
+
+	this->output = job.result;
+	this->outputPos = job.resultAsPos;
+
+	return outputPos;
 }
 
 Vector<Vector<Point> > TextureSynthesizer::resampleAsPos(const MatrixXf & src, int width) 
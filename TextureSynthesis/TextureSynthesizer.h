@@ -8,7 +8,7 @@
 #include <QColor>
 
 #include "Synthesizer.h"
-#include "Tiler.h"
+#include "SynthesisRunner.h"
 
 namespace Synth
 {
@@ -19,9 +19,12 @@ namespace Synth
 		private:
 			MatrixXf input;
 			MatrixXf output;
+			Vector<Vector<Point> > outputPos;
 
 			Synthesizer * s;
 
+			Vector<Vector<Point> > synthesizeJob(SynthesisJob & job);
+
 		protected:
 			void run();
 
@@ -41,9 +44,18 @@ namespace Synth
 			MatrixXf imageOutputMatrix();
 
 			// Using patch-based texture synthesis
-			Vector<Vector<Point> > synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band);
+			Vector<Vector<Point> > synthesizeAsPos(const MatrixXf & src, int pad, int width, int block, int band, int candidates = 4);
 			Vector<Vector<Point> > outputAsPos();
 
+			// Runs the jobs in parallel on a SynthesisRunner
+			static void synthesizeBatch(Vector<SynthesisJob> & jobs);
+
+			// Patch-based on a downsampled source, refined up to full resolution
+			Vector<Vector<Point> > pyramidAsPos(const MatrixXf & src, int pad, int width, int block, int band, int levels = 2);
+
+			// Per pixel PatchMatch search, neighbours' matches as candidates
+			Vector<Vector<Point> > coherenceAsPos(const MatrixXf & src, int pad, int width, int block, int iterations = 2);
+
 			// Using smart tiling
 			Vector<Vector<Point> > tileAsPos(const MatrixXf & src, int width, int band);
 
@@ -1,10 +1,10 @@
 #include "Tiler.h"
 
-Tiler::Tiler(const MatrixXf & src, int bandSize, int tileCount)
+Tiler::Tiler(const MatrixXf & src, const SynthesisContext & context, int tileCount)
 {
 	src_img = src;
 
-	band_size = Min(bandSize, src.cols() - 1);
+	band_size = Min(context.bandSize, src.cols() - 1);
 	tile_count = Max(1, tileCount); // at least one
 
 	is_done = false;
@@ -12,78 +12,56 @@ Tiler::Tiler(const MatrixXf & src, int bandSize, int tileCount)
 
 MatrixXi Tiler::tileAsPos()
 {
-	MatrixXf square_diff, weighted_square_diff;
-	MatrixXf weight = LeftWeight(src_img.rows(), band_size);
+	int rows = src_img.rows();
+	int cols = src_img.cols();
+	int step = cols - band_size;
 
-	MatrixXf L = src_img;
-	MatrixXi Li = NumberedMatrix(src_img.rows(), src_img.cols());
+	MatrixXf weight = LeftWeight(rows, band_size);
 
-	// Final result for tiles as positions
-	Vector<MatrixXi> texture;
-	texture.reserve(tile_count);
+	// Every tile adds 'step' columns, the whole target is known up front.
+	// The current tile always sits at [i * step, i * step + cols)
+	MatrixXi target = MatrixXi::Zero(rows, tile_count * step + cols);
+	target.block(0, 0, rows, cols) = NumberedMatrix(rows, cols);
 
-	// last tile result
-	MatrixXi result;
+	MatrixXf cost(rows, band_size);
+	MatrixXi band, lastBand;
+	Vector<int> seam(rows);
 
 	for(int i = 0; i < tile_count; i++)
 	{
-		int l_rows = L.rows(), l_cols = L.cols();
-		int bandStart = l_cols - band_size;
-
-		square_diff = (fromRight(L, band_size) - fromLeft(src_img, band_size)).array().square();
-
-		//weighted_square_diff = square_diff;
-		weighted_square_diff = square_diff.array() * weight.array();
-		//float total_cost = (weighted_square_diff).sum();
-
-		MatrixXi mask = cut_mask(weighted_square_diff);
-
-		// Identity = all zeros
-		result = MatrixXi::Zero(l_rows, l_cols + (src_img.cols() - band_size));
-
-		// Copy positions to result
-		for(int y = 0; y < result.rows(); y++){
-			int mask_x = 0;
-
-			for(int x = 0; x < result.cols(); x++){
-				if(x < bandStart)
+		int start = i * step;
+		int bandStart = start + step;
+
+		// Same band positions as the last tile give the same cut, which is
+		// always the case when the band is at most half the source
+		band = target.block(0, bandStart, rows, band_size);
+
+		if(i == 0 || band != lastBand)
+		{
+			#pragma omp parallel for
+			for(int y = 0; y < rows; y++)
+			{
+				for(int x = 0; x < band_size; x++)
 				{
-					result.coeffRef(y,x) = Li.coeffRef(y,x);
-				}
-				else
-				{
-					if(mask_x < mask.cols() && !mask(y, mask_x++))
-						result.coeffRef(y,x) = Li.coeffRef(y, x);
-					else
-						result.coeffRef(y,x) = Li.coeffRef(y, (x - (l_cols -band_size)) % l_cols);
+					float diff = src_img(band(y,x) - 1) - src_img(y,x);
+					cost(y,x) = diff * diff * weight(y,x);
 				}
 			}
-		}
 
-		// Split into two parts, Texture part:
-		texture.push_back(result.topLeftCorner(l_rows, l_cols - band_size));
+			cut_seam(cost, seam);
+			lastBand = band;
+		}
 
-		// New input part
-		Li = result.topRightCorner(l_rows, l_cols);
-		L = FromPositionMatrix(src_img, Li);
+		// Next tile is a copy of the current one shifted by 'step', the current
+		// one is kept left of the seam. Copy backwards since the two overlap
+		#pragma omp parallel for
+		for(int y = 0; y < rows; y++)
+		{
+			for(int x = cols - 1; x > seam[y]; x--)
+				target(y, bandStart + x) = target(y, start + x);
+		}
 	}
 
-	// Last part
-	texture.push_back(result.topRightCorner( src_img.rows(), src_img.cols()));
-
-	int rows = src_img.rows();
-	int cols = texture[0].cols();
-
-	// compute actual target column count
-	int target_cols = 0;
-	for(size_t i = 0; i < texture.size(); i++) target_cols += texture[i].cols();
-
-	// Create target pos matrix
-	MatrixXi target = MatrixXi::Ones(rows, target_cols);
-
-	for(size_t i = 0; i < texture.size(); i++)
-		target.block(0, i * cols, rows, texture[i].cols()) = texture[i];
-
 	return target;
 }
 
@@ -105,89 +83,43 @@ MatrixXi Tiler::stitchAsPos(const MatrixXi & left_img, const MatrixXi & right_im
 	return result;
 }
 
-MatrixXi Tiler::cut_mask(const MatrixXf & costMatrix)
+void Tiler::cut_seam(const MatrixXf & costMatrix, Vector<int> & seam)
 {
-	Graph<int, float> g;
-
-	StdMap<Point, int> node;
-	StdMap<int, Point> point;
-
 	int rows = costMatrix.rows();
 	int cols = costMatrix.cols();
 
-	// Register nodes
-	for(int y = 0; y < rows; y++){
-		for(int x = 0; x < cols; x++){
-			point[node.size()] = Point(x,y);
-			node[Point(x,y)] = node.size();
-		}
-	}
+	// Accumulated cost, a seam moves at most one column per row
+	MatrixXf E = costMatrix;
 
-	// Connect with costs
-	for(int y = 0; y < rows; y++){
-		for(int x = 0; x < cols; x++){
-			Point p1 = Point( x     , y     );
-			Point p2 = Point( x + 1 , y     );
-			Point p3 = Point( x     , y + 1 );
+	for(int y = 1; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			float minCost = E(y - 1, x);
 
-			if(node.find(p2) != node.end()){
-				float cost = costMatrix(p1.y, p1.x) + costMatrix(p2.y, p2.x);
-				g.AddEdge(node[p1], node[p2], cost);
-			}
+			if(x > 0)			minCost = Min(minCost, E(y - 1, x - 1));
+			if(x < cols - 1)	minCost = Min(minCost, E(y - 1, x + 1));
 
-			if(node.find(p3) != node.end()){
-				float cost = costMatrix(p1.y, p1.x) + costMatrix(p3.y, p3.x);
-				g.AddEdge(node[p1], node[p3], cost);
-			}
+			E(y,x) += minCost;
 		}
 	}
 
-	int start = node.size();
-	int end = start + 1;
+	// Trace back from the cheapest end
+	int x = 0;
+	for(int i = 1; i < cols; i++)
+		if(E(rows - 1, i) < E(rows - 1, x)) x = i;
 
-	// Connect start and end nodes to graph
-	for(int i = 0; i < cols; i++)
-	{
-		g.AddEdge(start, node[Point(i, 0)], 0);
-		g.AddEdge(end, node[Point(i, rows - 1)], 0);
-	}
+	seam[rows - 1] = x;
 
-	// Get shortest path
-	std::list<int> path = g.DijkstraShortestPath(start, end);
-
-	// Create full mask and set path nodes to zero
-	MatrixXi mask = MatrixXi::Ones(rows, cols);
-	for(std::list<int>::iterator i = path.begin(); i != path.end(); i++)
+	for(int y = rows - 2; y >= 0; y--)
 	{
-		Point p = point[*i];
-		mask.coeffRef(p.y, p.x) = 0;
-	}
+		int best = x;
 
-	// fill in the rest of the mask, row by row
-	for(int i = 0; i < rows; i++)
-	{
-		fillMask(0, i, mask); // vertical (left)
-	}
-
-	/*for(int i = 0; i < cols; i++)
-	{
-		fillMask(i, 0, mask); // horiz (top)
-		fillMask(i, rows - 1, mask); // horiz (bottom)
-	}*/
-
-	return mask;
-}
-
-void Tiler::fillMask(int x, int y, MatrixXi & m)
-{
-	if(x >= 0 && x < m.cols() && y >= 0 && y < m.rows() && m(y,x) == 1)
-	{
-		m.coeffRef(y,x) = 0;
+		if(x > 0 && E(y, x - 1) < E(y, best))			best = x - 1;
+		if(x < cols - 1 && E(y, x + 1) < E(y, best))	best = x + 1;
 
-		fillMask(x + 1, y,     m);
-		fillMask(x - 1, y,     m);
-		fillMask(x,     y + 1, m);
-		fillMask(x,     y - 1, m);
+		x = best;
+		seam[y] = x;
 	}
 }
 
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Globals.h"
-#include "Graph.h"
 
 class Tiler
 {
@@ -14,12 +13,11 @@ private:
 	// Stitching function
 	MatrixXi stitchAsPos(const MatrixXi & left_img, const MatrixXi & right_img, const MatrixXi & mask);
 
-	// Mask computations
-	MatrixXi cut_mask(const MatrixXf & costMatrix);
-	void fillMask(int x, int y, MatrixXi & m);
+	// Minimum cost vertical seam through the band, one column per row
+	void cut_seam(const MatrixXf & costMatrix, Vector<int> & seam);
 
 public:
-	Tiler(const MatrixXf & src, int bandSize, int tileCount);
+	Tiler(const MatrixXf & src, const SynthesisContext & context, int tileCount);
 
 	// Tiling function
 	MatrixXi tileAsPos();
@@ -1,7 +1,10 @@
 #include "WeightMatrix.h"
 
-WeightMatrix::WeightMatrix(BlockType type)
+WeightMatrix::WeightMatrix(BlockType type, const SynthesisContext & context)
 {
+	int BlockSize = context.blockSize;
+	int BandSize = context.bandSize;
+
 	this->m = MatrixXf::Zero(BlockSize, BlockSize);
 
 	switch (type)
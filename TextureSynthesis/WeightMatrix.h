@@ -9,5 +9,5 @@ private:
 public:
 	MatrixXf m;
 
-	WeightMatrix(BlockType);
+	WeightMatrix(BlockType, const SynthesisContext & context);
 };